@@ -15,20 +15,31 @@
 #include <expected>
 #include <iomanip>
 #include <iostream>
-#include <memory>
-#include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 
 import prodigy.engine;
-import prodigy.mcts;
 import prodigy.move_generator;
 
-int main() {
+// Arguments make up a single command, such as bench, which is handled instead of reading commands from standard input.
+int main(const int argc, const char* const argv[]) {
   try {
     using namespace prodigy;
+    using namespace std::literals::chrono_literals;
     move_generator::init().value();
     asio::io_context io_context(1);
+    if (argc > 1) {
+      std::string command;
+      for (const auto arg : std::span(argv + 1, argv + argc)) {
+        command.append(arg).push_back(' ');
+      }
+      Engine engine(io_context, make_mcts_strategy, 1s);
+      engine.handle(command);
+      // Runs until any search the command started has ended.
+      io_context.run();
+      return 0;
+    }
     asio::signal_set signal_set(io_context, SIGINT, SIGTERM);
     signal_set.async_wait([&](const asio::error_code& error, auto&&...) {
       if (!error) {
@@ -38,12 +49,7 @@ int main() {
     asio::co_spawn(
         io_context,
         [&] -> asio::awaitable<void> {
-          using namespace std::literals::chrono_literals;
-          Engine engine(
-              io_context,
-              std::make_unique<MCTSStrategy<mcts::EvaluationPolicy, mcts::UCTPolicy>>(
-                  std::nullopt, 1ULL << 31, [] { return mcts::EvaluationPolicy(); }, [] { return mcts::UCTPolicy(4); }),
-              100ms);
+          Engine engine(io_context, make_mcts_strategy, 1s);
           asio::posix::stream_descriptor input(io_context, ::dup(STDIN_FILENO));
           std::string buffer;
           while (true) {
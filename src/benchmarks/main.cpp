@@ -0,0 +1,304 @@
+#include <nanobench.h>
+
+#include <CLI/CLI.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <expected>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+import prodigy.core;
+import prodigy.evaluation;
+import prodigy.mcts;
+import prodigy.move_generator;
+
+namespace prodigy {
+namespace {
+// The perft suite's best known positions, the last with 218 legal moves.
+constexpr std::array<std::string_view, 6> FENS{
+    STARTING_FEN,
+    KIWIPETE,
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPPPNnPP/RNBQK2R w KQ - 1 8",
+    "R6R/3Q4/1Q4Q1/4Q3/2Q4Q/Q4Q2/pp1Q4/kBNN1KB1 w - - 0 1",
+};
+
+// Counts moves without playing them, so that only walking is measured.
+class MoveCounter : public move_generator::Visitor<MoveCounter> {
+ public:
+  constexpr explicit MoveCounter(std::size_t& move_count) noexcept : move_count_(move_count) {}
+
+  template <move_generator::Node::Context>
+  constexpr void visit_pawn_move(const auto&) const noexcept {
+    ++move_count_;
+  }
+
+  template <move_generator::Node::Context>
+  constexpr void visit_knight_move(const auto&) const noexcept {
+    ++move_count_;
+  }
+
+  template <move_generator::Node::Context>
+  constexpr void visit_bishop_move(const auto&) const noexcept {
+    ++move_count_;
+  }
+
+  template <move_generator::Node::Context>
+  constexpr void visit_rook_move(const auto&) const noexcept {
+    ++move_count_;
+  }
+
+  template <move_generator::Node::Context>
+  constexpr void visit_queen_move(const auto&) const noexcept {
+    ++move_count_;
+  }
+
+  template <move_generator::Node::Context>
+  constexpr void visit_king_move(const auto&) const noexcept {
+    ++move_count_;
+  }
+
+  constexpr void is_check() const noexcept {}
+
+ private:
+  std::size_t& move_count_;
+};
+
+// Moves toggle pieces, so applying one twice restores the board and each iteration times a move and its undo.
+void bench_board_apply(ankerl::nanobench::Bench& bench) {
+  bench.title("Board::apply").unit("move").batch(2);
+  const auto run = [&](const std::string_view name, const std::string_view fen, const auto& move) {
+    auto board = parse_fen(fen).value().board;
+    bench.run(std::string(name), [&] {
+      board.apply<Color::WHITE>(move);
+      board.apply<Color::WHITE>(move);
+      ankerl::nanobench::doNotOptimizeAway(board);
+    });
+  };
+  run("quiet move", STARTING_FEN,
+      QuietMove{
+          .origin = to_bitboard(Square::E2),
+          .target = to_bitboard(Square::E4),
+          .piece_type = PieceType::PAWN,
+      });
+  run("capture", KIWIPETE,
+      Capture{
+          .origin = to_bitboard(Square::F3),
+          .target = to_bitboard(Square::F6),
+          .aggressor = PieceType::QUEEN,
+          .victim = PieceType::KNIGHT,
+      });
+  run("castle", KIWIPETE, ColorTraits<Color::WHITE>::KINGSIDE_CASTLE);
+  run("quiet promotion", "8/P5k1/8/8/8/8/1K1p4/8 w - - 0 1",
+      QuietPromotion{
+          .origin = to_bitboard(Square::A7),
+          .target = to_bitboard(Square::A8),
+          .promotion = PieceType::QUEEN,
+      });
+  run("capture promotion", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 0 1",
+      CapturePromotion{
+          .origin = to_bitboard(Square::D7),
+          .target = to_bitboard(Square::C8),
+          .promotion = PieceType::QUEEN,
+          .victim = PieceType::BISHOP,
+      });
+  run("en passant", "rnbqkbnr/ppp2ppp/8/3Pp3/8/8/PPPP1PPP/RNBQKBNR w KQkq e6 0 1",
+      EnPassant{
+          .origin = to_bitboard(Square::D5),
+          .target = to_bitboard(Square::E6),
+          .victim_origin = to_bitboard(Square::E5),
+      });
+}
+
+void bench_walk(ankerl::nanobench::Bench& bench) {
+  bench.title("walk").unit("node").batch(1);
+  for (const auto fen : FENS) {
+    move_generator::dispatch(parse_fen(fen).value(), [&]<auto context>(const auto node) {
+      bench.run(std::string(fen), [&] {
+        auto move_count = 0UZ;
+        move_generator::walk<context>(node, MoveCounter(move_count));
+        ankerl::nanobench::doNotOptimizeAway(move_count);
+      });
+    });
+  }
+}
+
+// Both slider backends whatever the build option, from every origin through the same occupancies, so that one run
+// compares them on the machine at hand.
+void bench_slider_attacks(ankerl::nanobench::Bench& bench) {
+  bench.title("slider attacks").unit("attack set").batch(64 * 2);
+  std::mt19937_64 generator;
+  const auto occupancy = Bitboard{generator() & generator()};
+  const auto run = [&](const char* const name, const auto& bishop_attack_set, const auto& rook_attack_set) {
+    bench.run(name, [&] {
+      Bitboard attacks{};
+      for (std::uint8_t i = 0; i < 64; ++i) {
+        const auto origin = static_cast<Square>(i);
+        attacks ^= bishop_attack_set(origin, occupancy) ^ rook_attack_set(origin, occupancy);
+      }
+      ankerl::nanobench::doNotOptimizeAway(attacks);
+    });
+  };
+  run("magic bitboards", move_generator::BishopMagicBitboards::attack_set,
+      move_generator::RookMagicBitboards::attack_set);
+  run("Kogge-Stone", move_generator::BishopKoggeStone::attack_set, move_generator::RookKoggeStone::attack_set);
+}
+
+// The perft suite, all white to move, counted one position at a time and then BATCH_SIZE at a time in vector lanes.
+void bench_count_moves(ankerl::nanobench::Bench& bench) {
+  bench.title("count_moves").unit("position").batch(FENS.size());
+  std::vector<Position> positions;
+  for (const auto fen : FENS) {
+    positions.push_back(parse_fen(fen).value());
+  }
+  std::vector<int> move_counts(positions.size());
+  bench.run("scalar", [&] {
+    for (auto i = 0UZ; i < positions.size(); ++i) {
+      move_counts[i] = move_generator::dispatch(positions[i], [&]<auto context>(const auto& node) {
+        return move_generator::count_moves<context>(node,
+                                                    move_generator::make_constraints<context.side_to_move>(node.board));
+      });
+    }
+    ankerl::nanobench::doNotOptimizeAway(move_counts.data());
+  });
+  bench.run("batch", [&] {
+    move_generator::count_moves<Color::WHITE>(positions, move_counts);
+    ankerl::nanobench::doNotOptimizeAway(move_counts.data());
+  });
+}
+
+// Each expanded node is freed before the next, so the arena stays warm.
+void bench_expand(ankerl::nanobench::Bench& bench) {
+  bench.title("expand").unit("node").batch(1);
+  mcts::Arena arena(1 << 20);
+  for (const auto fen : FENS) {
+    move_generator::dispatch(parse_fen(fen).value(), [&]<auto context>(const auto& node) {
+      bench.run(std::string(fen), [&] {
+        const auto& expanded_node = mcts::expand<context>(node, arena);
+        ankerl::nanobench::doNotOptimizeAway(&expanded_node);
+        arena.reset(sizeof(expanded_node) + expanded_node.edges().size_bytes());
+      });
+    });
+  }
+}
+
+// Selects among the edges of the widest position, with uneven statistics so that every edge's bound is computed.
+void bench_uct_select(ankerl::nanobench::Bench& bench) {
+  bench.title("UCTPolicy::select").unit("select").batch(1);
+  mcts::Arena arena(1 << 16);
+  mcts::SimulationCount parent_visit_count = 1;
+  auto& node = move_generator::dispatch(parse_fen(FENS.back()).value(), [&]<auto context>(const auto& node) -> auto& {
+    return mcts::expand<context>(node, arena);
+  });
+  for (auto i = 0UZ; auto& edge : node.edges()) {
+    for (auto simulation = 0UZ; simulation <= i % 7; ++simulation, ++parent_visit_count) {
+      static_cast<void>(edge.on_simulation_complete(static_cast<float>(static_cast<int>(i % 11) - 5) / 5));
+    }
+    ++i;
+  }
+  const mcts::UCTPolicy tree_policy(4);
+  bench.run(std::format("{} edges", node.edges().size()), [&] {
+    ankerl::nanobench::doNotOptimizeAway(&tree_policy.select(parent_visit_count, node.edges()));
+  });
+}
+
+// A quiet move and its reverse leave the score where it was, so iterations don't drift.
+void bench_evaluator(ankerl::nanobench::Bench& bench) {
+  bench.title("Evaluator").unit("call");
+  evaluation::Evaluator evaluator;
+  evaluator.on_search_start(parse_fen(KIWIPETE).value().board);
+  evaluator.on_simulation_start();
+  const QuietMove move{
+      .origin = to_bitboard(Square::F3),
+      .target = to_bitboard(Square::G3),
+      .piece_type = PieceType::QUEEN,
+  };
+  const QuietMove reverse{
+      .origin = move.target,
+      .target = move.origin,
+      .piece_type = PieceType::QUEEN,
+  };
+  bench.batch(2).run("on_move", [&] {
+    evaluator.on_move<Color::WHITE>(move);
+    evaluator.on_move<Color::WHITE>(reverse);
+    ankerl::nanobench::doNotOptimizeAway(evaluator);
+  });
+  evaluator.on_simulation_start();
+  bench.batch(1).run("evaluate",
+                     [&] { ankerl::nanobench::doNotOptimizeAway(evaluator.evaluate<Color::WHITE>()); });
+}
+
+void bench_parse_fen(ankerl::nanobench::Bench& bench) {
+  bench.title("parse_fen").unit("FEN").batch(FENS.size());
+  bench.run("perft suite", [&] {
+    for (const auto fen : FENS) {
+      ankerl::nanobench::doNotOptimizeAway(parse_fen(fen));
+    }
+  });
+}
+
+// Other threads complete simulations on the same statistics while this one is timed, as searchers do at the root.
+void bench_simulation_statistics(ankerl::nanobench::Bench& bench) {
+  bench.title("SimulationStatistics::on_simulation_complete").unit("simulation").batch(1);
+  for (const auto thread_count : {1UZ, 2UZ, 4UZ, 8UZ}) {
+    if (thread_count > std::max(std::thread::hardware_concurrency(), 1U)) {
+      break;
+    }
+    mcts::SimulationStatistics statistics;
+    std::vector<std::jthread> contenders;
+    for (auto i = 1UZ; i < thread_count; ++i) {
+      contenders.emplace_back([&](const std::stop_token stop_token) {
+        while (!stop_token.stop_requested()) {
+          static_cast<void>(statistics.on_simulation_complete(0.5F));
+        }
+      });
+    }
+    bench.run(std::format("{} threads", thread_count),
+              [&] { ankerl::nanobench::doNotOptimizeAway(statistics.on_simulation_complete(0.5F)); });
+  }
+}
+}  // namespace
+}  // namespace prodigy
+
+int main(int argc, char** argv) {
+  using namespace prodigy;
+  CLI::App app("Runs micro-benchmarks of the move generator, evaluation and search kernels.");
+  std::string json_path;
+  app.add_option("--json", json_path, "Write the nanobench results to this file as JSON, to diff between commits");
+  CLI11_PARSE(app, argc, argv);
+  try {
+    move_generator::init().value();
+    ankerl::nanobench::Bench bench;
+    bench_board_apply(bench);
+    bench_slider_attacks(bench);
+    bench_walk(bench);
+    bench_count_moves(bench);
+    bench_expand(bench);
+    bench_uct_select(bench);
+    bench_evaluator(bench);
+    bench_parse_fen(bench);
+    bench_simulation_statistics(bench);
+    if (!json_path.empty()) {
+      std::ofstream json(json_path);
+      ankerl::nanobench::render(ankerl::nanobench::templates::json(), bench, json);
+    }
+  } catch (const std::bad_expected_access<std::string_view>& exception) {
+    std::clog << exception.error() << '\n';
+    return EXIT_FAILURE;
+  } catch (const std::exception& exception) {
+    std::clog << exception.what() << '\n';
+    return EXIT_FAILURE;
+  }
+}
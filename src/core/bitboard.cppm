@@ -27,6 +27,14 @@ constexpr Square square_of(const Bitboard bitboard) noexcept {
 
 constexpr int popcount(const Bitboard bitboard) noexcept { return std::popcount(std::to_underlying(bitboard)); }
 
+// The n-th set bit counting from the least significant one, or no bit if there are too few.
+constexpr Bitboard nth_bit(Bitboard bitboard, int n) noexcept {
+  for (; n > 0; --n) {
+    bitboard &= Bitboard{std::to_underlying(bitboard) - 1};
+  }
+  return bitboard & Bitboard{-std::to_underlying(bitboard)};
+}
+
 constexpr Bitboard unsafe_shift(const Bitboard bitboard, const Direction direction) noexcept {
   switch (const auto shift = std::to_underlying(direction); direction) {
     case Direction::NORTH:
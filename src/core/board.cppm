@@ -1,5 +1,6 @@
 module;
 
+#include <cstdint>
 #include <magic_enum/magic_enum_utility.hpp>
 #include <optional>
 #include <utility>
@@ -12,6 +13,7 @@ import :containers;
 import :move;
 import :piece_type;
 import :square;
+import :zobrist;
 
 export namespace prodigy {
 class Board {
@@ -23,6 +25,8 @@ class Board {
     magic_enum::enum_for_each<Square>([&](const auto square) {
       if (const auto piece = piece_placement[square]; piece.has_value()) {
         occupancy_ |= colors_[piece->first] |= pieces_[piece->first][piece->second] |= to_bitboard(square);
+        mailbox_[square] = encode(piece->first, piece->second);
+        hash_ ^= piece_hash(piece->first, piece->second, square);
       }
     });
   }
@@ -35,6 +39,16 @@ class Board {
 
   constexpr Bitboard occupancy() const noexcept { return occupancy_; }
 
+  // Zobrist hash of the piece placement alone.
+  constexpr Hash hash() const noexcept { return hash_; }
+
+  constexpr std::optional<std::pair<Color, PieceType>> piece_at(const Square square) const noexcept {
+    if (const auto piece = mailbox_[square]; piece != 0) {
+      return std::pair(Color{static_cast<bool>(piece >> 3)}, PieceType{static_cast<std::uint8_t>((piece & 7) - 1)});
+    }
+    return std::nullopt;
+  }
+
   template <Color side_to_move>
   constexpr void apply(const QuietMove& move) noexcept {
     const auto& [origin, target, piece_type] = move;
@@ -55,30 +69,25 @@ class Board {
   constexpr void apply(const Castle& move) noexcept {
     const auto& [king_origin, king_target, rook_origin, rook_target] = move;
     const auto king_mask = king_origin | king_target;
-    pieces_[side_to_move][PieceType::KING] ^= king_mask;
+    toggle<side_to_move>(PieceType::KING, king_mask);
     const auto rook_mask = rook_origin | rook_target;
-    pieces_[side_to_move][PieceType::ROOK] ^= rook_mask;
-    const auto color_mask = king_mask | rook_mask;
-    colors_[side_to_move] ^= color_mask;
-    occupancy_ ^= color_mask;
+    toggle<side_to_move>(PieceType::ROOK, rook_mask);
+    occupancy_ ^= king_mask | rook_mask;
   }
 
   template <Color side_to_move>
   constexpr void apply(const QuietPromotion& move) noexcept {
     const auto& [origin, target, promotion] = move;
-    pieces_[side_to_move][PieceType::PAWN] ^= origin;
-    pieces_[side_to_move][promotion] ^= target;
-    const auto color_mask = origin | target;
-    colors_[side_to_move] ^= color_mask;
-    occupancy_ ^= color_mask;
+    toggle<side_to_move>(PieceType::PAWN, origin);
+    toggle<side_to_move>(promotion, target);
+    occupancy_ ^= origin | target;
   }
 
   template <Color side_to_move>
   constexpr void apply(const CapturePromotion& move) noexcept {
     const auto& [origin, target, promotion, victim] = move;
-    pieces_[side_to_move][PieceType::PAWN] ^= origin;
-    pieces_[side_to_move][promotion] ^= target;
-    colors_[side_to_move] ^= origin | target;
+    toggle<side_to_move>(PieceType::PAWN, origin);
+    toggle<side_to_move>(promotion, target);
     toggle<!side_to_move>(victim, target);
     occupancy_ ^= origin;
   }
@@ -95,17 +104,30 @@ class Board {
     occupancy_ ^= victim_origin;
   }
 
-  friend constexpr bool operator==(const Board& lhs, const Board& rhs) noexcept { return lhs.pieces_ == rhs.pieces_; }
+  friend constexpr bool operator==(const Board& lhs, const Board& rhs) noexcept {
+    return lhs.hash_ == rhs.hash_ && lhs.pieces_ == rhs.pieces_ && lhs.mailbox_ == rhs.mailbox_;
+  }
 
  private:
+  // Empty squares are 0, so toggling a piece on and off the mailbox is an XOR just like on the bitboards.
+  static constexpr std::uint8_t encode(const Color color, const PieceType piece_type) noexcept {
+    return static_cast<std::uint8_t>((std::to_underlying(color) << 3) | (std::to_underlying(piece_type) + 1));
+  }
+
   template <Color color>
   constexpr void toggle(const PieceType piece_type, const Bitboard mask) noexcept {
     pieces_[color][piece_type] ^= mask;
     colors_[color] ^= mask;
+    for_each_square(mask, [&, piece = encode(color, piece_type)](const auto square) {
+      mailbox_[square] ^= piece;
+      hash_ ^= piece_hash(color, piece_type, square);
+    });
   }
 
   EnumMap<Color, EnumMap<PieceType, Bitboard>> pieces_{};
   EnumMap<Color, Bitboard> colors_{};
   Bitboard occupancy_{};
+  EnumMap<Square, std::uint8_t> mailbox_{};
+  Hash hash_{};
 };
 }  // namespace prodigy
@@ -14,3 +14,4 @@ export import :ply;
 export import :position;
 export import :square;
 export import :visitor;
+export import :zobrist;
@@ -9,6 +9,7 @@ import :board;
 import :castling_rights;
 import :color;
 import :ply;
+import :zobrist;
 
 export namespace prodigy {
 struct Position {
@@ -19,6 +20,12 @@ struct Position {
   Ply halfmove_clock;
   std::uint16_t fullmove_number;
 
+  // Ignores the clocks, so positions that differ only by them share a hash.
+  constexpr Hash hash() const noexcept {
+    return board.hash() ^ side_to_move_hash(side_to_move) ^ castling_rights_hash(castling_rights) ^
+           en_passant_hash(en_passant_victim_origin);
+  }
+
   friend constexpr bool operator==(const Position&, const Position&) = default;
 };
 }  // namespace prodigy
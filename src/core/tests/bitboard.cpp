@@ -34,6 +34,17 @@ TEST_CASE("popcount") {
   enum_for_each<Square>([](const auto square) { STATIC_REQUIRE(popcount(to_bitboard(square)) == 1); });
 }
 
+TEST_CASE("nth bit") {
+  static constexpr auto bitboard = to_bitboard(Square::B1) | to_bitboard(Square::E4) | to_bitboard(Square::H8);
+  STATIC_REQUIRE(nth_bit(bitboard, 0) == to_bitboard(Square::B1));
+  STATIC_REQUIRE(nth_bit(bitboard, 1) == to_bitboard(Square::E4));
+  STATIC_REQUIRE(nth_bit(bitboard, 2) == to_bitboard(Square::H8));
+  STATIC_REQUIRE(empty(nth_bit(bitboard, 3)));
+  enum_for_each<Square>([](const auto square) {
+    STATIC_REQUIRE(nth_bit(~Bitboard(), std::to_underlying(square.value)) == to_bitboard(square));
+  });
+}
+
 TEST_CASE("shift") {
   enum_for_each<Direction>([](const auto direction) {
     STATIC_REQUIRE(empty(shift(Bitboard(), direction)));
@@ -80,6 +80,7 @@ TEST_CASE("starting board") {
     enum_for_each<Color>([&](const auto color) { occupancy |= board[color]; });
     return occupancy;
   }());
+  enum_for_each<Square>([](const auto square) { STATIC_REQUIRE(board.piece_at(square) == piece_placement[square]); });
 }
 
 TEST_CASE("quiet move") {
@@ -0,0 +1,79 @@
+#include <catch2/catch_test_macros.hpp>
+#include <magic_enum/magic_enum_utility.hpp>
+#include <set>
+#include <type_traits>
+
+import prodigy.core;
+
+namespace prodigy {
+namespace {
+using namespace magic_enum;
+
+TEST_CASE("distinct keys") {
+  std::set<Hash> keys;
+  enum_for_each<Color>([&](const auto color) {
+    enum_for_each<PieceType>([&](const auto piece_type) {
+      enum_for_each<Square>(
+          [&](const auto square) { REQUIRE(keys.insert(piece_hash(color, piece_type, square)).second); });
+    });
+  });
+  for (std::underlying_type_t<CastlingRights> underlying = 1; underlying < 16; ++underlying) {
+    REQUIRE(keys.insert(castling_rights_hash(CastlingRights{underlying})).second);
+  }
+  enum_for_each<File>([&](const auto file) {
+    REQUIRE(keys.insert(en_passant_hash(to_bitboard(to_square(file, Rank::FOUR)))).second);
+  });
+  REQUIRE(keys.insert(side_to_move_hash(Color::BLACK)).second);
+  STATIC_REQUIRE(castling_rights_hash(CastlingRights()) == Hash());
+  STATIC_REQUIRE(side_to_move_hash(Color::WHITE) == Hash());
+  STATIC_REQUIRE(en_passant_hash(Bitboard()) == Hash());
+}
+
+TEST_CASE("castling rights hash") {
+  STATIC_REQUIRE((castling_rights_hash(CastlingRights::WHITE_KINGSIDE) ^
+                  castling_rights_hash(CastlingRights::BLACK_QUEENSIDE)) ==
+                 castling_rights_hash(CastlingRights::WHITE_KINGSIDE | CastlingRights::BLACK_QUEENSIDE));
+}
+
+TEST_CASE("incremental hash") {
+  static constexpr auto position = parse_fen(KIWIPETE).value();
+  static constexpr auto board = [] {
+    auto board = position.board;
+    board.apply<Color::WHITE>(Capture{
+        .origin = to_bitboard(Square::E5),
+        .target = to_bitboard(Square::F7),
+        .aggressor = PieceType::KNIGHT,
+        .victim = PieceType::PAWN,
+    });
+    board.apply<Color::WHITE>(KingsideCastle{{
+        .king_origin = to_bitboard(Square::E1),
+        .king_target = to_bitboard(Square::G1),
+        .rook_origin = to_bitboard(Square::H1),
+        .rook_target = to_bitboard(Square::F1),
+    }});
+    board.apply<Color::BLACK>(Capture{
+        .origin = to_bitboard(Square::H3),
+        .target = to_bitboard(Square::G2),
+        .aggressor = PieceType::PAWN,
+        .victim = PieceType::PAWN,
+    });
+    return board;
+  }();
+  STATIC_REQUIRE(board.hash() ==
+                 parse_fen("r3k2r/p1ppqNb1/bn2pnp1/3P4/1p2P3/2N2Q2/PPPBBPpP/R4RK1 w kq - 0 1").value().board.hash());
+  STATIC_REQUIRE(board.hash() != position.board.hash());
+}
+
+TEST_CASE("position hash") {
+  static constexpr auto position = parse_fen("rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1").value();
+  STATIC_REQUIRE(position.hash() ==
+                 parse_fen("rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3 12 34").value().hash());
+  STATIC_REQUIRE(position.hash() !=
+                 parse_fen("rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR w KQkq e3 0 1").value().hash());
+  STATIC_REQUIRE(position.hash() !=
+                 parse_fen("rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQk e3 0 1").value().hash());
+  STATIC_REQUIRE(position.hash() !=
+                 parse_fen("rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1").value().hash());
+}
+}  // namespace
+}  // namespace prodigy
@@ -0,0 +1,83 @@
+module;
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <magic_enum/magic_enum_utility.hpp>
+#include <utility>
+
+#include "macros.h"
+
+export module prodigy.core:zobrist;
+
+import :bitboard;
+import :castling_rights;
+import :color;
+import :containers;
+import :piece_type;
+import :square;
+
+export namespace prodigy {
+enum class Hash : std::uint64_t {};
+
+PRODIGY_ENUM_BITWISE_OPERATORS(Hash)
+}  // namespace prodigy
+
+namespace prodigy {
+struct ZobristKeys {
+  EnumMap<Color, EnumMap<PieceType, EnumMap<Square, Hash>>> pieces;
+  // Indexed by the underlying value since EnumMap only covers the individual flags.
+  std::array<Hash, 16> castling_rights;
+  EnumMap<File, Hash> en_passant_files;
+  Hash black_to_move;
+};
+
+inline constexpr auto ZOBRIST_KEYS = [] consteval {
+  // SplitMix64 with a fixed seed, so keys are identical across builds.
+  auto state = std::uint64_t{0x9E3779B97F4A7C15};
+  const auto next = [&] {
+    auto z = state += 0x9E3779B97F4A7C15;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    return Hash{z ^ (z >> 31)};
+  };
+  ZobristKeys keys{};
+  magic_enum::enum_for_each<Color>([&](const auto color) {
+    magic_enum::enum_for_each<PieceType>([&](const auto piece_type) {
+      magic_enum::enum_for_each<Square>([&](const auto square) { keys.pieces[color][piece_type][square] = next(); });
+    });
+  });
+  // Each right has its own key and a set of rights hashes to their XOR, so rights can be toggled independently.
+  for (const auto castling_right : {CastlingRights::WHITE_KINGSIDE, CastlingRights::WHITE_QUEENSIDE,
+                                    CastlingRights::BLACK_KINGSIDE, CastlingRights::BLACK_QUEENSIDE}) {
+    const auto key = next();
+    for (auto castling_rights = 0UZ; castling_rights < keys.castling_rights.size(); ++castling_rights) {
+      if (any(CastlingRights{static_cast<std::uint8_t>(castling_rights)} & castling_right)) {
+        keys.castling_rights[castling_rights] ^= key;
+      }
+    }
+  }
+  magic_enum::enum_for_each<File>([&](const auto file) { keys.en_passant_files[file] = next(); });
+  keys.black_to_move = next();
+  return keys;
+}();
+}  // namespace prodigy
+
+export namespace prodigy {
+constexpr Hash piece_hash(const Color color, const PieceType piece_type, const Square square) noexcept {
+  return ZOBRIST_KEYS.pieces[color][piece_type][square];
+}
+
+constexpr Hash castling_rights_hash(const CastlingRights castling_rights) noexcept {
+  return ZOBRIST_KEYS.castling_rights[std::to_underlying(castling_rights)];
+}
+
+constexpr Hash side_to_move_hash(const Color side_to_move) noexcept {
+  return side_to_move == Color::BLACK ? ZOBRIST_KEYS.black_to_move : Hash();
+}
+
+constexpr Hash en_passant_hash(const Bitboard en_passant_victim_origin) noexcept {
+  return any(en_passant_victim_origin) ? ZOBRIST_KEYS.en_passant_files[file_of(square_of(en_passant_victim_origin))]
+                                       : Hash();
+}
+}  // namespace prodigy
@@ -1,144 +1,509 @@
 module;
 
 #include <algorithm>
+#include <asio/post.hpp>
+#include <array>
 #include <asio/steady_timer.hpp>
+#include <bit>
 #include <cassert>
 #include <chrono>
-#include <concepts>
 #include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
 #include <iostream>
 #include <memory>
 #include <optional>
-#include <type_traits>
+#include <semaphore>
+#include <span>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <variant>
+#include <vector>
 
 module prodigy.engine;
 
 import prodigy.core;
+import prodigy.evaluation;
 import prodigy.move_generator;
 import prodigy.uci;
 
 namespace prodigy {
-Engine::Engine(asio::io_context& io_context, std::unique_ptr<Strategy> strategy,
-               const std::chrono::steady_clock::duration poll_interval)
-    : uci::Engine(io_context), timer_(io_context), strategy_(std::move(strategy)), poll_interval_(poll_interval) {
-  assert(strategy_ != nullptr);
+Engine::Engine(asio::io_context& io_context, MakeStrategy make_strategy,
+               const std::chrono::steady_clock::duration info_interval)
+    : uci::Engine(io_context),
+      deadline_timer_(io_context),
+      make_strategy_(std::move(make_strategy)),
+      info_timer_(io_context),
+      info_interval_(info_interval) {
+  assert(make_strategy_ != nullptr);
 }
 
-void Engine::set_position(const Position& position) { position_ = position; }
+void Engine::set_debug(const bool debug) { debug_ = debug; }
+
+void Engine::set_position(const Position& position) {
+  position_ = position;
+  history_.clear();
+}
 
 namespace {
-class Visitor : public move_generator::Visitor<Visitor> {
- public:
-  explicit Visitor(Position& position, const uci::Move move) noexcept : position_(position), move_(move) {}
+template <Color side_to_move>
+bool is_attacked(const Board& board, const Bitboard squares) noexcept {
+  auto attacked = false;
+  for_each_square(squares, [&](const auto square) {
+    attacked |= any(move_generator::attackers_to(board, square, board.occupancy()) & board[!side_to_move]);
+  });
+  return attacked;
+}
 
-  template <move_generator::Node::Context child_context>
-  void visit_pawn_move(const auto& move) const noexcept {
-    visit<PieceType::PAWN, child_context>(move);
+constexpr Bitboard make_castle_path(const Castle& castle) noexcept {
+  const auto direction = std::to_underlying(castle.rook_origin) < std::to_underlying(castle.king_origin)
+                             ? Direction::WEST
+                             : Direction::EAST;
+  Bitboard path{};
+  for (auto square = shift(castle.king_origin, direction); square != castle.rook_origin;
+       square = shift(square, direction)) {
+    path |= square;
   }
+  return path;
+}
 
-  template <move_generator::Node::Context child_context>
-  void visit_knight_move(const auto& move) const noexcept {
-    visit<PieceType::KNIGHT, child_context>(move);
+// Decodes the move against the board instead of generating every legal move to find it. Pseudo-legality is checked
+// with attackers_to and legality by looking for attacks on the king afterwards. Illegal moves leave the position as it
+// was.
+template <Color side_to_move>
+std::expected<void, std::string_view> apply(Position& position, const uci::Move move) noexcept {
+  using ColorTraits = ColorTraits<side_to_move>;
+  static constexpr auto forward = side_to_move == Color::WHITE ? Direction::NORTH : Direction::SOUTH;
+  auto& [board, active_color, castling_rights, en_passant_victim_origin, halfmove_clock, fullmove_number] = position;
+  const auto piece = board.piece_at(move.origin);
+  const auto victim = board.piece_at(move.target);
+  if (!piece.has_value() || piece->first != side_to_move ||
+      (victim.has_value() && victim->first == side_to_move)) {
+    return std::unexpected("Not a piece of the side to move, or a capture of one.");
+  }
+  const auto piece_type = piece->second;
+  const auto origin = to_bitboard(move.origin);
+  const auto target = to_bitboard(move.target);
+  const auto attacks_target = any(move_generator::attackers_to(board, move.target, board.occupancy()) & origin);
+  auto child = board;
+  Bitboard child_en_passant_victim_origin{};
+  const auto try_castle = [&](const Castle& castle, const CastlingRights castling_right) {
+    if (empty(castling_rights & castling_right) || origin != castle.king_origin || target != castle.king_target ||
+        any(board.occupancy() & make_castle_path(castle)) ||
+        is_attacked<side_to_move>(board, castle.king_origin | castle.rook_target | castle.king_target)) {
+      return false;
+    }
+    child.apply<side_to_move>(castle);
+    return true;
+  };
+  if (piece_type == PieceType::PAWN) {
+    if (any(target & ColorTraits::PROMOTION_RANK) != move.promotion.has_value()) {
+      return std::unexpected("Pawns promote exactly on the last rank.");
+    }
+    const auto single_push_target = shift(origin, forward);
+    if (attacks_target && victim.has_value()) {
+      if (move.promotion.has_value()) {
+        child.apply<side_to_move>(CapturePromotion{
+            .origin = origin,
+            .target = target,
+            .promotion = *move.promotion,
+            .victim = victim->second,
+        });
+      } else {
+        child.apply<side_to_move>(Capture{
+            .origin = origin,
+            .target = target,
+            .aggressor = PieceType::PAWN,
+            .victim = victim->second,
+        });
+      }
+    } else if (attacks_target && target == shift(en_passant_victim_origin, forward)) {
+      child.apply<side_to_move>(EnPassant{
+          .origin = origin,
+          .target = target,
+          .victim_origin = en_passant_victim_origin,
+      });
+    } else if (target == single_push_target && !victim.has_value()) {
+      if (move.promotion.has_value()) {
+        child.apply<side_to_move>(QuietPromotion{
+            .origin = origin,
+            .target = target,
+            .promotion = *move.promotion,
+        });
+      } else {
+        child.apply<side_to_move>(QuietMove{
+            .origin = origin,
+            .target = target,
+            .piece_type = PieceType::PAWN,
+        });
+      }
+    } else if (target == shift(single_push_target, forward) &&
+               any(single_push_target & ColorTraits::EN_PASSANT_TARGET_RANK) &&
+               empty(board.occupancy() & (single_push_target | target))) {
+      child.apply<side_to_move>(QuietMove{
+          .origin = origin,
+          .target = target,
+          .piece_type = PieceType::PAWN,
+      });
+      if (any(board[!side_to_move, PieceType::PAWN] &
+              (shift(target, Direction::EAST) | shift(target, Direction::WEST)))) {
+        child_en_passant_victim_origin = target;
+      }
+    } else {
+      return std::unexpected("Not a pawn move.");
+    }
+  } else if (move.promotion.has_value()) {
+    return std::unexpected("Only pawns promote.");
+  } else if (attacks_target) {
+    if (victim.has_value()) {
+      child.apply<side_to_move>(Capture{
+          .origin = origin,
+          .target = target,
+          .aggressor = piece_type,
+          .victim = victim->second,
+      });
+    } else {
+      child.apply<side_to_move>(QuietMove{
+          .origin = origin,
+          .target = target,
+          .piece_type = piece_type,
+      });
+    }
+  } else if (piece_type != PieceType::KING ||
+             !(try_castle(ColorTraits::KINGSIDE_CASTLE, ColorTraits::KINGSIDE_CASTLING_RIGHTS) ||
+               try_castle(ColorTraits::QUEENSIDE_CASTLE, ColorTraits::QUEENSIDE_CASTLING_RIGHTS))) {
+    return std::unexpected("Not a move of the piece.");
+  }
+  if (is_attacked<side_to_move>(child, child[side_to_move, PieceType::KING])) {
+    return std::unexpected("Leaves the king in check.");
+  }
+  board = child;
+  active_color = !side_to_move;
+  if (piece_type == PieceType::KING) {
+    castling_rights &= ~ColorTraits::CASTLING_RIGHTS;
   }
+#define _(COLOR, SIDE)                                                                 \
+  do {                                                                                 \
+    if (any((origin | target) & ColorTraits<Color::COLOR>::SIDE##_CASTLE.rook_origin)) { \
+      castling_rights &= ~ColorTraits<Color::COLOR>::SIDE##_CASTLING_RIGHTS;             \
+    }                                                                                  \
+  } while (false)
+  _(WHITE, KINGSIDE);
+  _(WHITE, QUEENSIDE);
+  _(BLACK, KINGSIDE);
+  _(BLACK, QUEENSIDE);
+#undef _
+  en_passant_victim_origin = child_en_passant_victim_origin;
+  halfmove_clock = piece_type == PieceType::PAWN || victim.has_value()
+                       ? Ply{0}
+                       : static_cast<Ply>(std::to_underlying(halfmove_clock) + 1);
+  if constexpr (side_to_move == Color::BLACK) {
+    ++fullmove_number;
+  }
+  return {};
+}
+}  // namespace
 
-  template <move_generator::Node::Context child_context>
-  void visit_bishop_move(const auto& move) const noexcept {
-    visit<PieceType::BISHOP, child_context>(move);
+void Engine::apply(const uci::Move move) {
+  const auto hash = position_.hash();
+  // Illegal moves are ignored, as GUIs expect.
+  if (const auto applied = position_.side_to_move == Color::WHITE ? prodigy::apply<Color::WHITE>(position_, move)
+                                                                   : prodigy::apply<Color::BLACK>(position_, move);
+      !applied.has_value()) {
+    return;
   }
+  if (position_.halfmove_clock == Ply{0}) {
+    history_.clear();
+  } else {
+    history_.push_back(hash);
+  }
+}
 
-  template <move_generator::Node::Context child_context>
-  void visit_rook_move(const auto& move) const noexcept {
-    visit<PieceType::ROOK, child_context>(move);
+void Engine::go(const uci::Go& params) {
+  if (strategy_ == nullptr || is_strategy_stale_) {
+    // Frees the old searchers' arenas before the new ones are mapped.
+    strategy_.reset();
+    auto strategy = make_strategy_(strategy_settings_);
+    if (!strategy.has_value()) {
+      // GUIs wait for a best move after each go, so a search that can't start still answers, and the next go retries.
+      std::cout << uci::Info{.string = std::string(strategy.error())} << '\n';
+      std::cout << "bestmove 0000" << std::endl;
+      return;
+    }
+    strategy_ = std::move(*strategy);
+    is_strategy_stale_ = false;
+  }
+  // Completion is handled on the engine's thread, after go returns.
+  strategy_->start(position_, history_, params,
+                   [this] { asio::post(deadline_timer_.get_executor(), [this] { on_search_complete(); }); });
+  searching_ = true;
+  search_start_ = std::chrono::steady_clock::now();
+  // Pondering is not timed until ponderhit, when the clock starts for real.
+  if (params.ponder) {
+    ponder_params_.emplace(params);
+    time_manager_ = TimeManager();
+  } else {
+    ponder_params_.reset();
+    time_manager_ = TimeManager(params, position_.side_to_move, move_overhead_, search_start_);
   }
+  manage_time();
+  async_info();
+}
 
-  template <move_generator::Node::Context child_context>
-  void visit_queen_move(const auto& move) const noexcept {
-    visit<PieceType::QUEEN, child_context>(move);
+// A ponder miss ends in a stop too. The GUI ignores the best move and starts the next search, which the strategy may
+// continue from what the search before pondering found under the reply actually played.
+void Engine::stop() {
+  if (!searching_) {
+    return;
   }
+  ponder_params_.reset();
+  if (is_search_complete_) {
+    finish_search();
+  } else {
+    strategy_->stop();
+  }
+}
 
-  template <move_generator::Node::Context child_context>
-  void visit_king_move(const auto& move) const noexcept {
-    visit<PieceType::KING, child_context>(move);
+void Engine::ponder_hit() {
+  if (!ponder_params_.has_value()) {
+    return;
+  }
+  // The tree searched so far is kept, and only the time from now on counts against the clock.
+  const auto params = *std::exchange(ponder_params_, std::nullopt);
+  time_manager_ = TimeManager(params, position_.side_to_move, move_overhead_, std::chrono::steady_clock::now());
+  if (is_search_complete_) {
+    finish_search();
+  } else {
+    manage_time();
   }
+}
 
-  void is_check() const noexcept {}
+std::span<const uci::Option> Engine::options() const {
+  static const std::vector<uci::Option> OPTIONS{
+      {
+          .name = "MultiPV",
+          .type = uci::Option::Type::SPIN,
+          .default_value = "1",
+          .min = 1,
+          .max = move_generator::MAX_MOVE_COUNT,
+      },
+      // Tells the GUI that the engine can ponder. Whether it does is up to the GUI, which sends go ponder.
+      {
+          .name = "Ponder",
+          .type = uci::Option::Type::CHECK,
+          .default_value = "false",
+      },
+      {
+          .name = "Move Overhead",
+          .type = uci::Option::Type::SPIN,
+          .default_value = "10",
+          .min = 0,
+          .max = 5000,
+      },
+      // 0 is every hardware thread.
+      {
+          .name = "Threads",
+          .type = uci::Option::Type::SPIN,
+          .default_value = "0",
+          .min = 0,
+          .max = 1024,
+      },
+      // In MiB, split between the threads' arenas.
+      {
+          .name = "Hash",
+          .type = uci::Option::Type::SPIN,
+          .default_value = "2048",
+          .min = 1,
+          .max = 1 << 20,
+      },
+      // The UCT exploration constant in hundredths, since UCI has no decimal options.
+      {
+          .name = "Exploration",
+          .type = uci::Option::Type::SPIN,
+          .default_value = "400",
+          .min = 0,
+          .max = 10000,
+      },
+      {
+          .name = "RolloutPolicy",
+          .type = uci::Option::Type::COMBO,
+          .default_value = "Evaluation",
+          .vars = {"Evaluation", "ByproductEvaluation", "NetworkEvaluation"},
+      },
+      // The network for NetworkEvaluation.
+      {
+          .name = "EvalFile",
+          .type = uci::Option::Type::STRING,
+          .default_value = "",
+      },
+      // Reproducible searches for a number of threads, for benchmarks.
+      {
+          .name = "Deterministic",
+          .type = uci::Option::Type::CHECK,
+          .default_value = "false",
+      },
+  };
+  return OPTIONS;
+}
 
- private:
-  template <PieceType piece_type, move_generator::Node::Context child_context>
-  void visit(const auto& move) const noexcept {
-    if (uci::to_move(move) != move_) {
-      return;
-    }
-    auto& [board, side_to_move, castling_rights, en_passant_victim_origin, halfmove_clock, fullmove_number] = position_;
-    board.apply<!child_context.side_to_move>(move);
-    side_to_move = child_context.side_to_move;
-    castling_rights = child_context.castling_rights;
-    if constexpr (child_context.can_en_passant) {
-      en_passant_victim_origin = move.target;
+void Engine::set_option(const std::string_view name, const uci::Option::Value& value) {
+  if (name == "MultiPV") {
+    multi_pv_ = static_cast<std::size_t>(std::get<std::int64_t>(value));
+  } else if (name == "Move Overhead") {
+    move_overhead_ = std::chrono::milliseconds(std::get<std::int64_t>(value));
+  } else {
+    set_strategy_option(name, value);
+  }
+}
+
+void Engine::set_strategy_option(const std::string_view name, const uci::Option::Value& value) {
+  if (name == "Threads") {
+    const auto threads = static_cast<std::size_t>(std::get<std::int64_t>(value));
+    strategy_settings_.threads = threads == 0 ? std::nullopt : std::optional(threads);
+  } else if (name == "Hash") {
+    strategy_settings_.arena_bytes = static_cast<std::size_t>(std::get<std::int64_t>(value)) << 20;
+  } else if (name == "Exploration") {
+    strategy_settings_.exploration_constant = static_cast<float>(std::get<std::int64_t>(value)) / 100;
+  } else if (name == "RolloutPolicy") {
+    // Combo values are the option's own vars.
+    const auto rollout_policy = std::get<std::string_view>(value);
+    if (rollout_policy == "Evaluation") {
+      strategy_settings_.rollout_policy = RolloutPolicyType::EVALUATION;
+    } else if (rollout_policy == "ByproductEvaluation") {
+      strategy_settings_.rollout_policy = RolloutPolicyType::BYPRODUCT_EVALUATION;
     } else {
-      en_passant_victim_origin = Bitboard();
+      strategy_settings_.rollout_policy = RolloutPolicyType::NETWORK_EVALUATION;
     }
-    if constexpr (std::same_as<std::remove_cvref_t<decltype(move)>, Capture> || piece_type == PieceType::PAWN) {
-      halfmove_clock = Ply{0};
+  } else if (name == "Deterministic") {
+    strategy_settings_.deterministic = std::get<bool>(value);
+  } else if (name == "EvalFile") {
+    if (const auto path = std::filesystem::path(std::get<std::string_view>(value)); path.empty()) {
+      strategy_settings_.network.reset();
     } else {
-      halfmove_clock = static_cast<Ply>(std::to_underlying(halfmove_clock) + 1);
-    }
-    if constexpr (child_context.side_to_move == Color::WHITE) {
-      ++fullmove_number;
+      strategy_settings_.network = std::make_shared<const evaluation::Network>(evaluation::load_network(path).value());
     }
+  } else {
+    return;
   }
+  // Replacing the strategy would end its search, so the new one is made by the next go.
+  is_strategy_stale_ = true;
+}
 
-  Position& position_;
-  const uci::Move move_;
+namespace {
+constexpr std::array<std::string_view, 7> BENCH_FENS{
+    STARTING_FEN,
+    KIWIPETE,
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPPPNnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r3k2r/8/8/5N2/8/8/8/R3K2R b KQkq - 0 36",
 };
 }  // namespace
 
-void Engine::apply(const uci::Move move) {
-  move_generator::dispatch(position_, [&]<auto context>(const auto& node) {
-    move_generator::walk<context>(node, Visitor(position_, move));
-  });
+void Engine::bench(const std::optional<std::size_t> simulations) {
+  if (searching_) {
+    return;
+  }
+  auto settings = strategy_settings_;
+  if (!settings.deterministic) {
+    settings.threads = 1;
+  }
+  // Frees the search strategy's arenas first. The next go makes a new one.
+  strategy_.reset();
+  const auto made_strategy = make_strategy_(settings);
+  if (!made_strategy.has_value()) {
+    std::cout << uci::Info{.string = std::string(made_strategy.error())} << std::endl;
+    return;
+  }
+  const auto& strategy = *made_strategy;
+  auto simulation_count = 0UZ;
+  std::uint64_t signature = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (const auto fen : BENCH_FENS) {
+    std::binary_semaphore complete(0);
+    strategy->start(parse_fen(fen).value(), {}, {.nodes = simulations.value_or(1 << 17)}, [&] { complete.release(); });
+    complete.acquire();
+    static_cast<void>(strategy->join());
+    const auto summary = strategy->summary().value();
+    simulation_count += summary.simulation_count;
+    signature = std::rotl(signature, 1) ^ summary.signature;
+  }
+  const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  std::cout << "Simulations: " << simulation_count << '\n';
+  std::cout << "Time (ms): " << time.count() << '\n';
+  const auto milliseconds = static_cast<std::size_t>(std::max<std::int64_t>(time.count(), 1));
+  std::cout << "Simulations/second: " << simulation_count * 1000 / milliseconds << '\n';
+  std::cout << "Signature: " << std::hex << signature << std::dec << std::endl;
 }
 
-void Engine::go(const uci::Go& params) {
-  strategy_->start(position_, params.nodes);
-  if (params.infinite) {
-    search_expiry_.reset();
-  } else {
-    search_expiry_.emplace(
-        std::chrono::steady_clock::now() +
-        params.move_time
-            .or_else([&] {
-              return params.time_remaining[position_.side_to_move].transform([&](const auto time_remaining) {
-                return time_remaining / static_cast<std::ptrdiff_t>(params.moves_to_go.value_or(40UZ));
-              });
-            })
-            .value());
+void Engine::manage_time() {
+  const auto now = std::chrono::steady_clock::now();
+  if (time_manager_.should_stop(now, strategy_->standings())) {
+    // The search is over once the strategy completes, so the time manager has nothing left to say.
+    time_manager_ = TimeManager();
+    stop();
+  } else if (const auto deadline = time_manager_.deadline(); deadline.has_value()) {
+    // Replaces any pending wait, whose handler then sees operation_aborted.
+    deadline_timer_.expires_at(std::min(*deadline, now + TIME_CHECK_INTERVAL));
+    deadline_timer_.async_wait([&](const asio::error_code& error) {
+      if (!error && searching_) {
+        manage_time();
+      }
+    });
   }
-  async_poll();
 }
 
-void Engine::stop() { strategy_->stop(); }
+void Engine::on_search_complete() {
+  is_search_complete_ = true;
+  if (!ponder_params_.has_value()) {
+    finish_search();
+  }
+}
 
-void Engine::async_poll() {
-  timer_.expires_after(poll_interval_);
-  if (search_expiry_.has_value()) {
-    timer_.expires_at(std::min(*search_expiry_, timer_.expiry()));
+void Engine::finish_search() {
+  searching_ = false;
+  is_search_complete_ = false;
+  deadline_timer_.cancel();
+  info_timer_.cancel();
+  print_info();
+  if (const auto best_move = strategy_->join(); !best_move.has_value()) {
+    std::cout << "bestmove 0000" << std::endl;
+  } else if (best_move->ponder.has_value()) {
+    std::cout << "bestmove " << best_move->move << " ponder " << *best_move->ponder << std::endl;
+  } else {
+    std::cout << "bestmove " << best_move->move << std::endl;
   }
-  timer_.async_wait([&](const asio::error_code& error) {
-    if (error) {
-      return;
-    }
-    if ((search_expiry_.has_value() && *search_expiry_ < std::chrono::steady_clock::now()) || strategy_->poll()) {
-      stop();
-      if (const auto move = strategy_->join(); move.has_value()) {
-        std::cout << "bestmove " << *move << std::endl;
-      } else {
-        std::cout << "bestmove 0000" << std::endl;
-      }
+}
+
+void Engine::async_info() {
+  info_timer_.expires_after(info_interval_);
+  info_timer_.async_wait([&](const asio::error_code& error) {
+    if (error || !searching_) {
       return;
     }
-    async_poll();
+    print_info();
+    async_info();
   });
 }
+
+void Engine::print_info() const {
+  const auto time =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - search_start_);
+  for (auto info : strategy_->info(multi_pv_)) {
+    info.time = time;
+    if (info.nodes.has_value() && time.count() > 0) {
+      info.nodes_per_second = *info.nodes * 1000 / static_cast<std::size_t>(time.count());
+    }
+    std::cout << info << '\n';
+  }
+  if (debug_) {
+    for (auto& line : strategy_->debug_info()) {
+      std::cout << uci::Info{.string = std::move(line)} << '\n';
+    }
+  }
+  std::cout << std::flush;
+}
 }  // namespace prodigy
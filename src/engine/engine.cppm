@@ -2,13 +2,18 @@ module;
 
 #include <asio/steady_timer.hpp>
 #include <chrono>
+#include <cstddef>
 #include <memory>
 #include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
 
 export module prodigy.engine;
 
 export import :mcts_strategy;
 export import :strategy;
+export import :time_manager;
 
 import prodigy.core;
 import prodigy.uci;
@@ -16,9 +21,15 @@ import prodigy.uci;
 export namespace prodigy {
 class Engine final : public uci::Engine {
  public:
-  explicit Engine(asio::io_context&, std::unique_ptr<Strategy>, std::chrono::steady_clock::duration poll_interval);
+  // Strategies are made on the first search, and again on the next search after an option they depend on changes.
+  explicit Engine(asio::io_context&, MakeStrategy, std::chrono::steady_clock::duration info_interval);
 
  private:
+  // Early stops depend on the root standings, so the time manager is checked this often and not only at its deadline.
+  static constexpr std::chrono::milliseconds TIME_CHECK_INTERVAL{50};
+
+  void set_debug(bool) override;
+
   void set_position(const Position&) override;
 
   void apply(uci::Move) override;
@@ -27,12 +38,53 @@ class Engine final : public uci::Engine {
 
   void stop() override;
 
-  void async_poll();
+  void ponder_hit() override;
+
+  std::span<const uci::Option> options() const override;
+
+  void set_option(std::string_view name, const uci::Option::Value&) override;
+
+  void set_strategy_option(std::string_view name, const uci::Option::Value&);
+
+  // Searches single-threaded unless searches are deterministic, with the other strategy options as set, so the
+  // signature only changes with the search.
+  void bench(std::optional<std::size_t> simulations) override;
+
+  // Stops the search when the time manager says so, and otherwise checks back at its deadline, which may have moved, or
+  // after TIME_CHECK_INTERVAL if that is sooner.
+  void manage_time();
+
+  void on_search_complete();
+
+  // Prints the best move, which waits for the end of pondering.
+  void finish_search();
+
+  void async_info();
+
+  // Followed by the strategy's debug info while debugging.
+  void print_info() const;
 
   Position position_;
-  asio::steady_timer timer_;
-  const std::unique_ptr<Strategy> strategy_;
-  const std::chrono::steady_clock::duration poll_interval_;
-  std::optional<const std::chrono::steady_clock::time_point> search_expiry_;
+  // Hashes of the positions played before position_ since the last irreversible move.
+  std::vector<Hash> history_;
+  asio::steady_timer deadline_timer_;
+  const MakeStrategy make_strategy_;
+  StrategySettings strategy_settings_;
+  // Null until the first search.
+  std::unique_ptr<Strategy> strategy_;
+  // Set when strategy_settings_ change.
+  bool is_strategy_stale_ = false;
+  asio::steady_timer info_timer_;
+  const std::chrono::steady_clock::duration info_interval_;
+  std::chrono::steady_clock::time_point search_start_;
+  TimeManager time_manager_;
+  // Timer handlers may already be queued when a search completes.
+  bool searching_ = false;
+  bool is_search_complete_ = false;
+  // Set while pondering, to time the search on ponderhit.
+  std::optional<uci::Go> ponder_params_;
+  std::size_t multi_pv_ = 1;
+  bool debug_ = false;
+  std::chrono::milliseconds move_overhead_{10};
 };
 }  // namespace prodigy
@@ -1,10 +1,22 @@
 module;
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <expected>
 #include <functional>
+#include <ios>
+#include <iomanip>
+#include <memory>
 #include <optional>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 export module prodigy.engine:mcts_strategy;
 
@@ -14,38 +26,254 @@ import prodigy.uci;
 
 import :strategy;
 
+namespace prodigy {
+// Inverts the logistic that maps evaluations to rewards, clamped short of the infinite evaluations of certain results.
+std::int32_t to_centipawns(const float reward) noexcept {
+  const auto clamped_reward = std::clamp(reward, -0.999F, 0.999F);
+  return static_cast<std::int32_t>(std::lround(400 * std::log10((1 + clamped_reward) / (1 - clamped_reward))));
+}
+
+uci::Move move_of(const Color side_to_move, const mcts::Edge& edge) {
+  const auto to_move = [](const auto& move, auto&&...) { return uci::to_move(move); };
+  switch (side_to_move) {
+    case Color::WHITE:
+      return edge.visit_move<Color::WHITE>(to_move);
+    case Color::BLACK:
+      return edge.visit_move<Color::BLACK>(to_move);
+  }
+}
+
+// Follows the most simulated edges from the edge, stopping at leaves and at unexplored nodes.
+template <Color side_to_move>
+void append_principal_variation(const mcts::Edge& edge, std::vector<uci::Move>& principal_variation) {
+  principal_variation.push_back(
+      edge.visit_move<side_to_move>([](const auto& move, auto&&...) { return uci::to_move(move); }));
+  if (const auto child = edge.child(); child != nullptr && !child->edges().empty()) {
+    if (const auto& best_edge = *std::ranges::max_element(child->edges(), std::less(), &mcts::Edge::simulation_count);
+        best_edge.simulation_count() > 0) {
+      append_principal_variation<!side_to_move>(best_edge, principal_variation);
+    }
+  }
+}
+}  // namespace prodigy
+
 export namespace prodigy {
 template <mcts::RolloutPolicy RolloutPolicy, mcts::TreePolicy TreePolicy>
 class MCTSStrategy final : public Strategy {
  public:
+  // Searches are reproducible with a number of simulations per epoch. The other arguments make the algorithm.
   template <typename... Args>
-  explicit MCTSStrategy(Args&&... args) : algorithm_(std::forward<Args>(args)...) {}
+  explicit MCTSStrategy(const std::optional<mcts::SimulationCount> simulations_per_epoch, Args&&... args)
+      : simulations_per_epoch_(simulations_per_epoch), algorithm_(std::forward<Args>(args)...) {}
 
-  void start(const Position& position, const std::optional<std::size_t> nodes) override {
-    algorithm_.start(position, nodes).value();
+  void start(const Position& position, const std::span<const Hash> history, const uci::Go& params,
+             std::function<void()> on_complete) override {
+    auto max_depth = params.depth.transform(
+        [](const auto depth) { return std::max<std::size_t>(static_cast<std::size_t>(std::to_underlying(depth)), 1); });
+    // Mating in n moves takes n of the side to move's plies and n - 1 of the opponent's.
+    if (const auto mate_depth = params.mate.transform([](const auto mate) { return 2 * std::max(mate, 1UZ) - 1; });
+        mate_depth.has_value()) {
+      max_depth = std::min(max_depth.value_or(*mate_depth), *mate_depth);
+    }
+    const mcts::SearchLimits limits{
+        .simulations = params.nodes,
+        .max_depth = max_depth,
+        .stop_on_mate = params.mate.has_value(),
+        .is_root_edge_allowed = params.search_moves.empty()
+                                    ? std::function<bool(const mcts::Edge&)>()
+                                    : [&](const mcts::Edge& edge) {
+                                        return std::ranges::contains(params.search_moves,
+                                                                     move_of(position.side_to_move, edge));
+                                      },
+        .simulations_per_epoch = simulations_per_epoch_,
+    };
+    // Continues from the last tree when it reached the position, two plies down after the opponent's reply or one
+    // down in the reply tree after a ponder miss. Deterministic searches start fresh so that they only depend on the
+    // position, as do searches with a depth limit or search moves.
+    std::vector<const mcts::Edge*> path;
+    if (!simulations_per_epoch_.has_value() && !max_depth.has_value() && params.search_moves.empty()) {
+      if (last_tree_ != nullptr) {
+        path = last_tree_->find(position, 2);
+      }
+      if (path.empty() && reply_tree_ != nullptr) {
+        path = reply_tree_->find(position, 1);
+      }
+    }
+    // Copied before the searchers' arenas, where the last tree's nodes live, are reused.
+    auto tree = path.empty() ? nullptr : std::make_unique<mcts::Tree>(position, history, *path.back());
+    if (params.ponder && path.size() == 2) {
+      reply_tree_ = std::make_unique<mcts::Tree>(last_tree_->play(*path.front()), std::span<const Hash>(),
+                                                 *path.front());
+    } else {
+      reply_tree_.reset();
+    }
+    last_tree_.reset();
+    if (tree == nullptr) {
+      algorithm_.start(position, history, limits, std::move(on_complete)).value();
+    } else {
+      algorithm_.start(std::move(tree), limits, std::move(on_complete)).value();
+    }
   }
 
-  [[nodiscard]] bool poll() override { return algorithm_.poll().value(); }
-
   void stop() override { algorithm_.stop().value(); }
 
-  [[nodiscard]] std::optional<uci::Move> join() override {
-    if (const auto tree = algorithm_.join().value(); !tree->root().edges().empty()) {
-      const auto select_move = [&]<auto side_to_move> {
-        return std::ranges::max_element(tree->root().edges(), std::less(), &mcts::Edge::simulation_count)
-            ->template visit_move<side_to_move>([](const auto& move, auto&&...) { return uci::to_move(move); });
-      };
-      switch (tree->position().side_to_move) {
+  [[nodiscard]] std::vector<uci::Info> info(const std::size_t multi_pv) const override {
+    const auto progress = algorithm_.progress().value();
+    const auto& tree = progress.tree;
+    // Searchers keep updating the counts, so edges are ranked by a copy of them.
+    std::vector<std::pair<mcts::SimulationCount, const mcts::Edge*>> ranked_edges;
+    for (const auto& edge : tree.root().edges()) {
+      if (const auto simulation_count = edge.simulation_count(); simulation_count > 0) {
+        ranked_edges.emplace_back(simulation_count, &edge);
+      }
+    }
+    const auto line_count = std::min(multi_pv, ranked_edges.size());
+    std::ranges::partial_sort(ranked_edges, ranked_edges.begin() + static_cast<std::ptrdiff_t>(line_count),
+                              std::ranges::greater(), [](const auto& ranked_edge) { return ranked_edge.first; });
+    std::vector<uci::Info> info;
+    for (auto i = 0UZ; i < line_count; ++i) {
+      const auto [simulation_count, edge] = ranked_edges[i];
+      std::vector<uci::Move> principal_variation;
+      switch (tree.position().side_to_move) {
         case Color::WHITE:
-          return select_move.template operator()<Color::WHITE>();
+          append_principal_variation<Color::WHITE>(*edge, principal_variation);
+          break;
         case Color::BLACK:
-          return select_move.template operator()<Color::BLACK>();
+          append_principal_variation<Color::BLACK>(*edge, principal_variation);
+          break;
+      }
+      info.push_back({
+          .depth = principal_variation.size(),
+          .selective_depth = progress.max_depth,
+          .multi_pv = i + 1,
+          .centipawns = to_centipawns(edge->cumulative_reward() / static_cast<float>(simulation_count)),
+          .nodes = tree.simulation_count(),
+          .hash_full = static_cast<std::size_t>(progress.arena_usage * 1000),
+          .principal_variation = std::move(principal_variation),
+      });
+    }
+    return info;
+  }
+
+  [[nodiscard]] std::optional<RootStandings> standings() const override {
+    const auto& tree = algorithm_.progress().value().tree;
+    const mcts::Edge* best_edge = nullptr;
+    mcts::SimulationCount best_simulation_count = 0;
+    mcts::SimulationCount second_simulation_count = 0;
+    for (const auto& edge : tree.root().edges()) {
+      if (const auto simulation_count = edge.simulation_count(); simulation_count > best_simulation_count) {
+        second_simulation_count = std::exchange(best_simulation_count, simulation_count);
+        best_edge = &edge;
+      } else if (simulation_count > second_simulation_count) {
+        second_simulation_count = simulation_count;
+      }
+    }
+    if (best_edge == nullptr) {
+      return std::nullopt;
+    }
+    return RootStandings{
+        .best_move = move_of(tree.position().side_to_move, *best_edge),
+        .best_simulation_count = best_simulation_count,
+        .second_simulation_count = second_simulation_count,
+        .simulation_count = tree.simulation_count(),
+    };
+  }
+
+  // One line per searcher. Cycle counts are per simulation and only there when built with PRODIGY_INSTRUMENTATION.
+  [[nodiscard]] std::vector<std::string> debug_info() const override {
+    const auto searchers = algorithm_.progress().value().searchers;
+    std::vector<std::string> debug_info;
+    for (auto i = 0UZ; i < searchers.size(); ++i) {
+      const auto& searcher = searchers[i];
+      std::ostringstream line;
+      line << "searcher " << i << " arenabytes " << searcher.arena_bytes.load(std::memory_order_relaxed)
+           << " maxdepth " << searcher.max_depth.load(std::memory_order_relaxed);
+      if constexpr (mcts::INSTRUMENTATION) {
+        const auto counter = [&](const mcts::SearchCounter search_counter) {
+          return searcher.counters[search_counter].load(std::memory_order_relaxed);
+        };
+        const auto simulation_count = counter(mcts::SearchCounter::SIMULATIONS);
+        const auto per_simulation = [&](const mcts::SearchCounter search_counter) {
+          return static_cast<double>(counter(search_counter)) /
+                 static_cast<double>(std::max<std::uint64_t>(simulation_count, 1));
+        };
+        line << " simulations " << simulation_count << " expansions " << counter(mcts::SearchCounter::EXPANSIONS)
+             << " expansionraces " << counter(mcts::SearchCounter::EXPANSION_RACES) << std::fixed
+             << std::setprecision(1) << " averagedepth " << per_simulation(mcts::SearchCounter::TOTAL_DEPTH)
+             << std::setprecision(0) << " descentcycles " << per_simulation(mcts::SearchCounter::DESCENT_CYCLES)
+             << " expansioncycles " << per_simulation(mcts::SearchCounter::EXPANSION_CYCLES) << " rolloutcycles "
+             << per_simulation(mcts::SearchCounter::ROLLOUT_CYCLES) << " backpropagationcycles "
+             << per_simulation(mcts::SearchCounter::BACKPROPAGATION_CYCLES);
+      }
+      debug_info.push_back(std::move(line).str());
+    }
+    return debug_info;
+  }
+
+  [[nodiscard]] std::optional<BestMove> join() override {
+    last_tree_ = algorithm_.join().value();
+    const auto& tree = last_tree_;
+    if (tree->root().edges().empty()) {
+      return std::nullopt;
+    }
+    // Proven wins come first and proven losses last, whatever their simulation counts.
+    const auto rank = [](const mcts::Edge& edge) {
+      const auto proof = edge.proof();
+      return std::pair(proof == mcts::Proof::WIN ? 1 : proof == mcts::Proof::LOSS ? -1 : 0, edge.simulation_count());
+    };
+    const auto side_to_move = tree->position().side_to_move;
+    const auto& best_edge = *std::ranges::max_element(tree->root().edges(), std::less(), rank);
+    BestMove best_move{.move = move_of(side_to_move, best_edge)};
+    if (const auto child = best_edge.child(); child != nullptr && !child->edges().empty()) {
+      if (const auto& reply = *std::ranges::max_element(child->edges(), std::less(), &mcts::Edge::simulation_count);
+          reply.simulation_count() > 0) {
+        best_move.ponder = move_of(!side_to_move, reply);
       }
     }
-    return std::nullopt;
+    return best_move;
+  }
+
+  [[nodiscard]] std::optional<SearchSummary> summary() const override {
+    if (last_tree_ == nullptr) {
+      return std::nullopt;
+    }
+    return SearchSummary{
+        .simulation_count = last_tree_->simulation_count(),
+        .signature = last_tree_->signature(),
+    };
   }
 
  private:
+  const std::optional<mcts::SimulationCount> simulations_per_epoch_;
   mcts::Algorithm<RolloutPolicy, TreePolicy> algorithm_;
+  // Kept after join for summary.
+  std::unique_ptr<const mcts::Tree> last_tree_;
+  // The last tree's subtree under the move played, kept while pondering on the reply expected after it, so that a
+  // ponder miss continues from the reply actually played. Never searched, so its history is left empty.
+  std::unique_ptr<const mcts::Tree> reply_tree_;
 };
+
+// Makes a strategy with a UCT tree policy, with as many searchers and as large arenas as the settings say.
+std::expected<std::unique_ptr<Strategy>, std::string_view> make_mcts_strategy(const StrategySettings& settings) {
+  // Long enough for barriers to cost little next to the simulations, short enough that searchers don't select long on
+  // statistics the others have moved on from.
+  static constexpr mcts::SimulationCount SIMULATIONS_PER_EPOCH = 256;
+  const auto make_strategy = [&](auto&& make_rollout_policy) -> std::unique_ptr<Strategy> {
+    return std::make_unique<MCTSStrategy<std::invoke_result_t<decltype(make_rollout_policy)>, mcts::UCTPolicy>>(
+        settings.deterministic ? std::optional(SIMULATIONS_PER_EPOCH) : std::nullopt, settings.threads,
+        settings.arena_bytes, make_rollout_policy,
+        [&] { return mcts::UCTPolicy(settings.exploration_constant); });
+  };
+  switch (settings.rollout_policy) {
+    case RolloutPolicyType::EVALUATION:
+      return make_strategy([] { return mcts::EvaluationPolicy(); });
+    case RolloutPolicyType::BYPRODUCT_EVALUATION:
+      return make_strategy([] { return mcts::ByproductEvaluationPolicy(); });
+    case RolloutPolicyType::NETWORK_EVALUATION:
+      if (settings.network == nullptr) {
+        return std::unexpected("No network loaded.");
+      }
+      return make_strategy([&] { return mcts::NetworkEvaluationPolicy(settings.network); });
+  }
+}
 }  // namespace prodigy
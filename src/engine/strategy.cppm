@@ -1,24 +1,94 @@
 module;
 
 #include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <memory>
 #include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
 
 export module prodigy.engine:strategy;
 
 import prodigy.core;
+import prodigy.evaluation;
 import prodigy.uci;
 
 export namespace prodigy {
+// The root moves with the most simulations, which time management watches.
+struct RootStandings {
+  uci::Move best_move;
+  std::size_t best_simulation_count;
+  // Zero with a single root move.
+  std::size_t second_simulation_count;
+  std::size_t simulation_count;
+};
+
+struct BestMove {
+  uci::Move move;
+  // The expected reply, to ponder on.
+  std::optional<uci::Move> ponder;
+};
+
+// The last search, for bench.
+struct SearchSummary {
+  std::size_t simulation_count;
+  // Differs whenever searches explored differently, though only single-threaded searches reproduce it.
+  std::uint64_t signature;
+};
+
+enum class RolloutPolicyType : std::uint8_t {
+  EVALUATION,
+  BYPRODUCT_EVALUATION,
+  NETWORK_EVALUATION,
+};
+
+// What a strategy is made with, set through UCI options.
+struct StrategySettings {
+  // Every hardware thread when empty.
+  std::optional<std::size_t> threads;
+  std::size_t arena_bytes = 1UZ << 31;
+  float exploration_constant = 4;
+  RolloutPolicyType rollout_policy = RolloutPolicyType::EVALUATION;
+  // Searches give the same trees for a number of threads, at some cost in speed.
+  bool deterministic = false;
+  // Network evaluation only.
+  std::shared_ptr<const evaluation::Network> network;
+};
+
+class Strategy;
+
+using MakeStrategy =
+    std::function<std::expected<std::unique_ptr<Strategy>, std::string_view>(const StrategySettings&)>;
+
 class Strategy {
  public:
   virtual ~Strategy() = default;
 
-  virtual void start(const Position&, std::optional<std::size_t> nodes) = 0;
-
-  [[nodiscard]] virtual bool poll() = 0;
+  // Time controls are left to the engine. The strategy honors the search moves and the depth, node and mate limits, and
+  // calls on_complete from a search thread once the search has finished, whether it completed or was stopped.
+  virtual void start(const Position&, std::span<const Hash> history, const uci::Go&,
+                     std::function<void()> on_complete) = 0;
 
   virtual void stop() = 0;
 
-  [[nodiscard]] virtual std::optional<uci::Move> join() = 0;
+  // Progress of the running search, one line per principal variation up to multi_pv, best first. Called while
+  // searching, so it must not stop or slow the search.
+  [[nodiscard]] virtual std::vector<uci::Info> info(std::size_t multi_pv) const = 0;
+
+  // Empty before any root move is simulated. Called while searching, like info.
+  [[nodiscard]] virtual std::optional<RootStandings> standings() const = 0;
+
+  // Free text on how the running search goes, for debugging. Called while searching, like info.
+  [[nodiscard]] virtual std::vector<std::string> debug_info() const = 0;
+
+  // Empty when there are no legal moves.
+  [[nodiscard]] virtual std::optional<BestMove> join() = 0;
+
+  // Empty until a search is joined, and again once the next one starts.
+  [[nodiscard]] virtual std::optional<SearchSummary> summary() const = 0;
 };
 }  // namespace prodigy
@@ -3,12 +3,16 @@
 #include <catch2/generators/catch_generators.hpp>
 #include <chrono>
 #include <cstddef>
+#include <expected>
 #include <format>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 import prodigy.core;
 import prodigy.engine;
@@ -33,34 +37,77 @@ class MockStrategy : public Strategy {
   State state() const noexcept { return state_; }
 
  private:
-  void start(const Position& position, const std::optional<std::size_t> nodes) override {
-    REQUIRE_FALSE(nodes.has_value());
+  // Searches with a node limit complete at once.
+  void start(const Position& position, std::span<const Hash>, const uci::Go& params,
+             std::function<void()> on_complete) override {
     REQUIRE(std::exchange(state_, State::SEARCHING) == State::JOINED);
     position_.emplace(position);
+    simulation_count_ = params.nodes.value_or(0);
+    if (params.nodes.has_value()) {
+      state_ = State::STOPPING;
+      on_complete();
+    } else {
+      on_complete_ = std::move(on_complete);
+    }
   }
 
-  bool poll() override {
+  // Searches complete as soon as they are stopped.
+  void stop() override {
+    const auto state = std::exchange(state_, State::STOPPING);
+    REQUIRE(state != State::JOINED);
+    if (state == State::SEARCHING) {
+      on_complete_();
+    }
+  }
+
+  std::vector<uci::Info> info(std::size_t) const override {
     REQUIRE(state_ != State::JOINED);
-    return true;
+    return {};
   }
 
-  void stop() override { REQUIRE(std::exchange(state_, State::STOPPING) != State::JOINED); }
+  std::optional<RootStandings> standings() const override {
+    REQUIRE(state_ != State::JOINED);
+    return std::nullopt;
+  }
 
-  std::optional<uci::Move> join() override {
+  std::vector<std::string> debug_info() const override {
+    REQUIRE(state_ != State::JOINED);
+    return {};
+  }
+
+  std::optional<BestMove> join() override {
     REQUIRE(std::exchange(state_, State::JOINED) != State::JOINED);
     return std::nullopt;
   }
 
+  std::optional<SearchSummary> summary() const override {
+    REQUIRE(state_ == State::JOINED);
+    return SearchSummary{
+        .simulation_count = simulation_count_,
+        .signature = std::to_underlying(position().hash()),
+    };
+  }
+
   std::optional<const Position> position_;
+  std::function<void()> on_complete_;
+  std::size_t simulation_count_ = 0;
   State state_ = State::JOINED;
 };
 
+// Hands the engine its one strategy, since options never change.
+MakeStrategy make_once(std::unique_ptr<MockStrategy>& strategy) {
+  return [&](const StrategySettings&) -> std::expected<std::unique_ptr<Strategy>, std::string_view> {
+    REQUIRE(strategy != nullptr);
+    return std::move(strategy);
+  };
+}
+
 TEST_CASE("handle") {
   static_cast<void>(move_generator::init());
   asio::io_context io_context(1);
   auto strategy_ptr = std::make_unique<MockStrategy>();
   const auto& strategy = *strategy_ptr;
-  Engine engine(io_context, std::move(strategy_ptr), std::chrono::steady_clock::duration::zero());
+  Engine engine(io_context, make_once(strategy_ptr), std::chrono::steady_clock::duration::zero());
   const auto [command, expected_fen] = GENERATE(table<std::string, std::string_view>({
       {
           "position startpos",
@@ -90,6 +137,14 @@ TEST_CASE("handle") {
           "position startpos moves e2e4 g8f6 d2d4 b8c6 e1e2 c6d4",
           "r1bqkb1r/pppppppp/5n2/8/3nP3/8/PPP1KPPP/RNBQ1BNR w kq - 0 4",
       },
+      {
+          "position startpos moves e2e5",
+          STARTING_FEN,
+      },
+      {
+          "position fen 4k3/4r3/8/8/8/8/4N3/4K3 w - - 0 1 moves e2c3",
+          "4k3/4r3/8/8/8/8/4N3/4K3 w - - 0 1",
+      },
       {
           std::string("position fen ") + KIWIPETE,
           KIWIPETE,
@@ -142,5 +197,138 @@ TEST_CASE("handle") {
   io_context.run();
   REQUIRE(strategy.state() == MockStrategy::State::JOINED);
 }
+
+TEST_CASE("ponder") {
+  using namespace std::chrono_literals;
+  static_cast<void>(move_generator::init());
+  asio::io_context io_context;
+  auto strategy_ptr = std::make_unique<MockStrategy>();
+  const auto& strategy = *strategy_ptr;
+  Engine engine(io_context, make_once(strategy_ptr), std::chrono::steady_clock::duration::zero());
+  engine.handle("position startpos");
+  engine.handle("go ponder wtime 100 btime 100");
+  REQUIRE(strategy.state() == MockStrategy::State::SEARCHING);
+  SECTION("ponderhit") {
+    // The clock doesn't run while pondering.
+    io_context.run_for(50ms);
+    REQUIRE(strategy.state() == MockStrategy::State::SEARCHING);
+    engine.handle("ponderhit");
+    io_context.run();
+    REQUIRE(strategy.state() == MockStrategy::State::JOINED);
+  }
+  SECTION("ponder miss") {
+    engine.handle("stop");
+    io_context.run();
+    REQUIRE(strategy.state() == MockStrategy::State::JOINED);
+  }
+}
+
+TEST_CASE("strategy options") {
+  static_cast<void>(move_generator::init());
+  asio::io_context io_context;
+  std::vector<StrategySettings> settings;
+  Engine engine(
+      io_context,
+      [&](const StrategySettings& strategy_settings) -> std::expected<std::unique_ptr<Strategy>, std::string_view> {
+        settings.push_back(strategy_settings);
+        return std::make_unique<MockStrategy>();
+      },
+      std::chrono::steady_clock::duration::zero());
+  const auto search = [&] {
+    engine.handle("go infinite");
+    engine.handle("stop");
+    io_context.restart();
+    io_context.run();
+  };
+  engine.handle("position startpos");
+  search();
+  REQUIRE(settings.size() == 1);
+  REQUIRE_FALSE(settings.back().threads.has_value());
+  REQUIRE(settings.back().arena_bytes == 1UZ << 31);
+  REQUIRE(settings.back().exploration_constant == 4);
+  REQUIRE(settings.back().rollout_policy == RolloutPolicyType::EVALUATION);
+  engine.handle("setoption name Threads value 3");
+  engine.handle("setoption name Hash value 16");
+  engine.handle("setoption name Exploration value 250");
+  engine.handle("setoption name RolloutPolicy value byproductevaluation");
+  engine.handle("setoption name MultiPV value 2");
+  search();
+  REQUIRE(settings.size() == 2);
+  REQUIRE(settings.back().threads == 3);
+  REQUIRE(settings.back().arena_bytes == 16UZ << 20);
+  REQUIRE(settings.back().exploration_constant == 2.5F);
+  REQUIRE(settings.back().rollout_policy == RolloutPolicyType::BYPRODUCT_EVALUATION);
+  engine.handle("setoption name MultiPV value 3");
+  search();
+  REQUIRE(settings.size() == 2);
+  engine.handle("setoption name Threads value 0");
+  engine.handle("setoption name EvalFile value " TINY_NETWORK);
+  search();
+  REQUIRE(settings.size() == 3);
+  REQUIRE_FALSE(settings.back().threads.has_value());
+  REQUIRE(settings.back().network != nullptr);
+  REQUIRE_THROWS(engine.handle("setoption name EvalFile value missing.nnue"));
+}
+
+TEST_CASE("unavailable strategy") {
+  static_cast<void>(move_generator::init());
+  asio::io_context io_context;
+  auto make_count = 0;
+  Engine engine(
+      io_context,
+      [&](const StrategySettings& strategy_settings) -> std::expected<std::unique_ptr<Strategy>, std::string_view> {
+        ++make_count;
+        if (strategy_settings.network == nullptr) {
+          return std::unexpected("No network loaded.");
+        }
+        return std::make_unique<MockStrategy>();
+      },
+      std::chrono::steady_clock::duration::zero());
+  engine.handle("position startpos");
+  engine.handle("setoption name RolloutPolicy value NetworkEvaluation");
+  REQUIRE_NOTHROW(engine.handle("go infinite"));
+  engine.handle("stop");
+  io_context.run();
+  REQUIRE(make_count == 1);
+  engine.handle("setoption name EvalFile value " TINY_NETWORK);
+  engine.handle("go nodes 100");
+  io_context.restart();
+  io_context.run();
+  REQUIRE(make_count == 2);
+  engine.handle("setoption name EvalFile value <empty>");
+  REQUIRE_NOTHROW(engine.handle("bench 100"));
+  REQUIRE(make_count == 3);
+}
+
+TEST_CASE("bench") {
+  static_cast<void>(move_generator::init());
+  asio::io_context io_context;
+  std::vector<StrategySettings> settings;
+  Engine engine(
+      io_context,
+      [&](const StrategySettings& strategy_settings) -> std::expected<std::unique_ptr<Strategy>, std::string_view> {
+        settings.push_back(strategy_settings);
+        return std::make_unique<MockStrategy>();
+      },
+      std::chrono::steady_clock::duration::zero());
+  engine.handle("setoption name Hash value 16");
+  engine.handle("bench 100");
+  REQUIRE(settings.size() == 1);
+  REQUIRE(settings.back().threads == 1);
+  REQUIRE(settings.back().arena_bytes == 16UZ << 20);
+  // Searches don't keep bench's single thread.
+  engine.handle("position startpos");
+  engine.handle("go nodes 100");
+  io_context.run();
+  REQUIRE(settings.size() == 2);
+  REQUIRE_FALSE(settings.back().threads.has_value());
+  // Deterministic searches are reproducible with any number of threads.
+  engine.handle("setoption name Deterministic value true");
+  engine.handle("setoption name Threads value 4");
+  engine.handle("bench 100");
+  REQUIRE(settings.size() == 3);
+  REQUIRE(settings.back().deterministic);
+  REQUIRE(settings.back().threads == 4);
+}
 }  // namespace
 }  // namespace prodigy
@@ -2,43 +2,119 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_exception.hpp>
 #include <optional>
+#include <semaphore>
 
 import prodigy.core;
 import prodigy.engine;
 import prodigy.mcts;
 import prodigy.move_generator;
+import prodigy.uci;
 
 namespace prodigy {
 namespace {
 TEST_CASE("strategy") {
   static_cast<void>(move_generator::init());
   MCTSStrategy<mcts::EvaluationPolicy, mcts::UCTPolicy> strategy(
-      2UZ, 1UZ << 31, [] { return mcts::EvaluationPolicy(); }, [] { return mcts::UCTPolicy(2); });
+      std::nullopt, 2UZ, 1UZ << 31, [] { return mcts::EvaluationPolicy(); }, [] { return mcts::UCTPolicy(2); });
+  // Waits for the search through its completion callback, as the engine does.
+  const auto search = [&](const Position& position, const uci::Go& params) {
+    std::binary_semaphore completed(0);
+    strategy.start(position, {}, params, [&] { completed.release(); });
+    completed.acquire();
+  };
   SECTION("start") {
-    REQUIRE_NOTHROW(strategy.start(STARTING_POSITION, std::nullopt));
-    REQUIRE_THROWS(strategy.start(STARTING_POSITION, std::nullopt));
+    REQUIRE_NOTHROW(strategy.start(STARTING_POSITION, {}, {}, {}));
+    REQUIRE_THROWS(strategy.start(STARTING_POSITION, {}, {}, {}));
   }
-  SECTION("poll") {
-    REQUIRE_THROWS(strategy.poll());
-    REQUIRE_NOTHROW(strategy.start(STARTING_POSITION, 100));
-    while (!strategy.poll()) {
-    }
-    REQUIRE(strategy.poll());
+  SECTION("on complete") {
+    std::binary_semaphore completed(0);
+    REQUIRE_NOTHROW(strategy.start(STARTING_POSITION, {}, {}, [&] { completed.release(); }));
+    REQUIRE_NOTHROW(strategy.stop());
+    completed.acquire();
+    REQUIRE(strategy.join().has_value());
   }
   SECTION("stop") {
     REQUIRE_THROWS(strategy.stop());
-    REQUIRE_NOTHROW(strategy.start(STARTING_POSITION, 100));
+    REQUIRE_NOTHROW(strategy.start(STARTING_POSITION, {}, {.nodes = 100}, {}));
     REQUIRE_NOTHROW(strategy.stop());
     REQUIRE_NOTHROW(strategy.stop());
   }
   SECTION("join") {
     REQUIRE_THROWS(strategy.join());
-    REQUIRE_NOTHROW(strategy.start(STARTING_POSITION, 100));
-    REQUIRE(strategy.join().has_value());
+    REQUIRE_NOTHROW(strategy.start(STARTING_POSITION, {}, {.nodes = 100}, {}));
+    const auto best_move = strategy.join();
+    REQUIRE(best_move.has_value());
+    REQUIRE(best_move->ponder.has_value());
     REQUIRE_THROWS(strategy.join());
   }
+  SECTION("summary") {
+    REQUIRE_FALSE(strategy.summary().has_value());
+    REQUIRE_NOTHROW(strategy.start(STARTING_POSITION, {}, {.nodes = 100}, {}));
+    REQUIRE_FALSE(strategy.summary().has_value());
+    static_cast<void>(strategy.join());
+    const auto summary = strategy.summary();
+    REQUIRE(summary.has_value());
+    REQUIRE(summary->simulation_count == 100);
+    REQUIRE_NOTHROW(strategy.start(STARTING_POSITION, {}, {.nodes = 100}, {}));
+    REQUIRE_FALSE(strategy.summary().has_value());
+  }
+  SECTION("info") {
+    REQUIRE_THROWS(strategy.info(1));
+    REQUIRE_NOTHROW(search(STARTING_POSITION, {.nodes = 1000}));
+    const auto info = strategy.info(3);
+    REQUIRE(info.size() == 3);
+    for (auto i = 0UZ; i < info.size(); ++i) {
+      REQUIRE(info[i].multi_pv == i + 1);
+      REQUIRE(info[i].nodes == 1000);
+      REQUIRE(info[i].depth == info[i].principal_variation.size());
+      REQUIRE_FALSE(info[i].principal_variation.empty());
+      REQUIRE(info[i].selective_depth >= info[i].depth);
+      REQUIRE(info[i].hash_full.has_value());
+    }
+    REQUIRE(info[0].principal_variation.front() != info[1].principal_variation.front());
+  }
+  SECTION("debug info") {
+    REQUIRE_THROWS(strategy.debug_info());
+    REQUIRE_NOTHROW(search(STARTING_POSITION, {.nodes = 1000}));
+    const auto debug_info = strategy.debug_info();
+    REQUIRE(debug_info.size() == 2);
+    REQUIRE(debug_info[0].starts_with("searcher 0 "));
+    REQUIRE(debug_info[1].starts_with("searcher 1 "));
+    REQUIRE(debug_info[0].contains(" simulations 500 ") == mcts::INSTRUMENTATION);
+  }
+  SECTION("standings") {
+    REQUIRE_THROWS(strategy.standings());
+    REQUIRE_NOTHROW(search(STARTING_POSITION, {.nodes = 1000}));
+    const auto standings = strategy.standings();
+    REQUIRE(standings.has_value());
+    REQUIRE(standings->simulation_count == 1000);
+    REQUIRE(standings->best_simulation_count >= standings->second_simulation_count);
+    REQUIRE(standings->second_simulation_count > 0);
+    REQUIRE(strategy.info(1).front().principal_variation.front() == standings->best_move);
+  }
+  SECTION("search moves") {
+    REQUIRE_NOTHROW(strategy.start(STARTING_POSITION, {},
+                                   {.search_moves = {uci::parse_move("a2a3").value(), uci::parse_move("h2h3").value()},
+                                    .nodes = 1000},
+                                   {}));
+    const auto best_move = strategy.join();
+    REQUIRE(best_move.has_value());
+    REQUIRE((best_move->move == uci::parse_move("a2a3") || best_move->move == uci::parse_move("h2h3")));
+  }
+  SECTION("depth") {
+    REQUIRE_NOTHROW(search(STARTING_POSITION, {.depth = Ply{1}}));
+    REQUIRE(strategy.info(1).front().nodes < 1000);
+    REQUIRE(strategy.join().has_value());
+  }
+  SECTION("mate") {
+    REQUIRE_NOTHROW(search(parse_fen("6k1/5ppp/8/8/8/8/8/R3K3 w - - 0 1").value(), {.mate = 1}));
+    const auto best_move = strategy.join();
+    REQUIRE(best_move.has_value());
+    REQUIRE(best_move->move == uci::parse_move("a1a8"));
+    REQUIRE_FALSE(best_move->ponder.has_value());
+  }
   SECTION("checkmate") {
-    REQUIRE_NOTHROW(strategy.start(parse_fen("3k3R/R7/8/8/8/8/8/4K3 b - - 0 1").value(), std::nullopt));
+    REQUIRE_NOTHROW(strategy.start(parse_fen("3k3R/R7/8/8/8/8/8/4K3 b - - 0 1").value(), {}, {}, {}));
     REQUIRE_NOTHROW(strategy.stop());
     REQUIRE_FALSE(strategy.join().has_value());
   }
@@ -0,0 +1,97 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstddef>
+#include <string_view>
+
+import prodigy.core;
+import prodigy.engine;
+import prodigy.uci;
+
+namespace prodigy {
+namespace {
+using namespace std::chrono_literals;
+
+constexpr TimeManager::Clock::time_point START{};
+
+RootStandings standings(const std::string_view best_move, const std::size_t best_simulation_count,
+                        const std::size_t second_simulation_count, const std::size_t simulation_count) {
+  return {
+      .best_move = uci::parse_move(best_move).value(),
+      .best_simulation_count = best_simulation_count,
+      .second_simulation_count = second_simulation_count,
+      .simulation_count = simulation_count,
+  };
+}
+
+TEST_CASE("untimed") {
+  for (auto time_manager : {TimeManager(), TimeManager(uci::Go{.infinite = true}, Color::WHITE, 0ms, START),
+                            TimeManager(uci::Go{.nodes = 1000}, Color::WHITE, 0ms, START)}) {
+    REQUIRE_FALSE(time_manager.deadline().has_value());
+    REQUIRE_FALSE(time_manager.should_stop(START + 1h, standings("e2e4", 1000, 0, 1000)));
+  }
+}
+
+TEST_CASE("move time") {
+  TimeManager time_manager(uci::Go{.move_time = 1000ms}, Color::WHITE, 10ms, START);
+  REQUIRE(time_manager.deadline() == START + 990ms);
+  REQUIRE_FALSE(time_manager.should_stop(START + 500ms, standings("e2e4", 500, 400, 1000)));
+  // UCI asks for exactly the move time, however settled the search.
+  REQUIRE_FALSE(time_manager.should_stop(START + 900ms, standings("e2e4", 1000, 0, 1000)));
+  REQUIRE_FALSE(time_manager.should_stop(START + 950ms, standings("d2d4", 1000, 0, 1000)));
+  REQUIRE(time_manager.deadline() == START + 990ms);
+  REQUIRE(time_manager.should_stop(START + 990ms, standings("e2e4", 500, 400, 1000)));
+}
+
+TEST_CASE("clock") {
+  uci::Go params;
+  params.time_remaining[Color::BLACK] = 40s;
+  params.increment[Color::BLACK] = 1s;
+  SECTION("moves to go unspecified") {
+    REQUIRE(TimeManager(params, Color::BLACK, 0ms, START).deadline() == START + 2s);
+  }
+  SECTION("moves to go") {
+    params.moves_to_go = 10;
+    REQUIRE(TimeManager(params, Color::BLACK, 0ms, START).deadline() == START + 5s);
+  }
+  SECTION("move overhead") {
+    REQUIRE(TimeManager(params, Color::BLACK, 400ms, START).deadline() == START + 1990ms);
+  }
+  SECTION("never more than remains") {
+    params.time_remaining[Color::BLACK] = 500ms;
+    REQUIRE(TimeManager(params, Color::BLACK, 100ms, START).deadline() == START + 400ms);
+  }
+  SECTION("other side's clock") {
+    REQUIRE_FALSE(TimeManager(params, Color::WHITE, 0ms, START).deadline().has_value());
+  }
+}
+
+TEST_CASE("stability") {
+  uci::Go params;
+  params.time_remaining[Color::WHITE] = 40s;
+  TimeManager time_manager(params, Color::WHITE, 0ms, START);
+  REQUIRE(time_manager.deadline() == START + 1s);
+  SECTION("settled") {
+    // At the same rate, 250 more simulations can't close a gap of 600.
+    REQUIRE(time_manager.should_stop(START + 800ms, standings("e2e4", 700, 100, 1000)));
+  }
+  SECTION("unsettled") {
+    REQUIRE_FALSE(time_manager.should_stop(START + 500ms, standings("e2e4", 500, 100, 1000)));
+  }
+  SECTION("extended") {
+    REQUIRE_FALSE(time_manager.should_stop(START + 100ms, standings("e2e4", 50, 40, 100)));
+    REQUIRE_FALSE(time_manager.should_stop(START + 200ms, standings("d2d4", 100, 90, 200)));
+    REQUIRE(time_manager.deadline() == START + 1250ms);
+    REQUIRE_FALSE(time_manager.should_stop(START + 300ms, standings("e2e4", 150, 140, 300)));
+    REQUIRE(time_manager.deadline() == START + 1500ms);
+    REQUIRE_FALSE(time_manager.should_stop(START + 1200ms, standings("e2e4", 600, 590, 1200)));
+    REQUIRE(time_manager.should_stop(START + 1500ms, standings("e2e4", 750, 740, 1500)));
+  }
+  SECTION("at most the maximum time") {
+    for (auto i = 0; i < 100; ++i) {
+      REQUIRE_FALSE(time_manager.should_stop(START + 100ms, standings(i % 2 == 0 ? "e2e4" : "d2d4", 50, 40, 100)));
+    }
+    REQUIRE(time_manager.deadline() == START + 4s);
+  }
+}
+}  // namespace
+}  // namespace prodigy
@@ -0,0 +1,77 @@
+module;
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+module prodigy.engine;
+
+import prodigy.core;
+import prodigy.uci;
+
+namespace prodigy {
+TimeManager::TimeManager(const uci::Go& params, const Color side_to_move,
+                         const std::chrono::milliseconds move_overhead, const Clock::time_point start) noexcept
+    : start_(start) {
+  if (params.infinite) {
+    return;
+  }
+  if (params.move_time.has_value()) {
+    optimum_time_ = std::max(*params.move_time - move_overhead, std::chrono::milliseconds::zero());
+    maximum_time_ = *optimum_time_;
+  } else if (const auto time_remaining = params.time_remaining[side_to_move]; time_remaining.has_value()) {
+    const auto available_time = std::max(*time_remaining - move_overhead, std::chrono::milliseconds::zero());
+    const auto moves_to_go =
+        static_cast<std::ptrdiff_t>(std::max(params.moves_to_go.value_or(DEFAULT_MOVES_TO_GO), 1UZ));
+    // The increment of this move is added to the clock once it is played, so it is spent as soon as it is earned.
+    const auto base_time = available_time / moves_to_go + params.increment[side_to_move];
+    optimum_time_ = std::min(base_time, available_time);
+    maximum_time_ = std::min(base_time * MAX_TIME_PER_OPTIMUM_TIME, available_time);
+    is_adaptive_ = true;
+  }
+}
+
+std::optional<TimeManager::Clock::time_point> TimeManager::deadline() const noexcept {
+  if (!optimum_time_.has_value()) {
+    return std::nullopt;
+  }
+  return start_ + budget();
+}
+
+bool TimeManager::should_stop(const Clock::time_point now, const std::optional<RootStandings>& standings) noexcept {
+  if (!optimum_time_.has_value()) {
+    return false;
+  }
+  if (!is_adaptive_) {
+    return now - start_ >= *optimum_time_;
+  }
+  if (standings.has_value()) {
+    if (best_move_.has_value() && standings->best_move != *best_move_) {
+      ++best_move_changes_;
+    }
+    best_move_ = standings->best_move;
+  }
+  const auto elapsed_time = now - start_;
+  const auto remaining_time = budget() - elapsed_time;
+  if (remaining_time <= Clock::duration::zero()) {
+    return true;
+  }
+  if (!standings.has_value() || elapsed_time <= Clock::duration::zero()) {
+    return false;
+  }
+  // Projects the simulation rate so far over the remaining time. Even if all of those simulations went to the second
+  // best move, it would not overtake the best one.
+  const auto remaining_simulations = static_cast<double>(standings->simulation_count) *
+                                     std::chrono::duration<double>(remaining_time) /
+                                     std::chrono::duration<double>(elapsed_time);
+  return static_cast<double>(standings->best_simulation_count - standings->second_simulation_count) >
+         remaining_simulations;
+}
+
+TimeManager::Clock::duration TimeManager::budget() const noexcept {
+  return std::min<Clock::duration>(
+      *optimum_time_ + *optimum_time_ * static_cast<std::ptrdiff_t>(best_move_changes_) / EXTENSIONS_PER_OPTIMUM_TIME,
+      maximum_time_);
+}
+}  // namespace prodigy
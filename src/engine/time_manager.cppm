@@ -0,0 +1,52 @@
+module;
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+export module prodigy.engine:time_manager;
+
+import prodigy.core;
+import prodigy.uci;
+
+import :strategy;
+
+export namespace prodigy {
+// Budgets the time of a search from the clock. While searching, it stops early once the best move can no longer be
+// overtaken, and extends the budget while the best move keeps changing. Move times are exact, so neither applies.
+class TimeManager {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // A search that is not timed, which only ends when it completes or is stopped.
+  TimeManager() = default;
+
+  // Searches without move time or remaining time are not timed, and neither are infinite searches. The move overhead is
+  // kept back for communicating with the GUI.
+  explicit TimeManager(const uci::Go&, Color side_to_move, std::chrono::milliseconds move_overhead,
+                       Clock::time_point start) noexcept;
+
+  // The latest time to check back with should_stop, if the search is timed.
+  [[nodiscard]] std::optional<Clock::time_point> deadline() const noexcept;
+
+  // Called periodically while searching, with the standings of the search so far.
+  [[nodiscard]] bool should_stop(Clock::time_point now, const std::optional<RootStandings>&) noexcept;
+
+ private:
+  // Budgets time for this many moves when the GUI doesn't say how many moves are left until the next time control.
+  static constexpr auto DEFAULT_MOVES_TO_GO = 40UZ;
+  // Each change of best move extends the budget by a quarter of the optimum time, up to the maximum time.
+  static constexpr auto EXTENSIONS_PER_OPTIMUM_TIME = 4;
+  static constexpr auto MAX_TIME_PER_OPTIMUM_TIME = 4;
+
+  Clock::duration budget() const noexcept;
+
+  Clock::time_point start_;
+  std::optional<Clock::duration> optimum_time_;
+  Clock::duration maximum_time_{};
+  // Set when the budget comes from the clock rather than a move time.
+  bool is_adaptive_ = false;
+  std::optional<uci::Move> best_move_;
+  std::size_t best_move_changes_ = 0;
+};
+}  // namespace prodigy
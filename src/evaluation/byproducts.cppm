@@ -0,0 +1,39 @@
+module;
+
+#include <cstdint>
+#include <magic_enum/magic_enum_utility.hpp>
+
+export module prodigy.evaluation:byproducts;
+
+import prodigy.core;
+
+export namespace prodigy::evaluation {
+// What generating the legal moves of a node already knows about it, from the point of view of the side to move.
+struct Byproducts {
+  EnumMap<PieceType, std::uint8_t> mobility;
+  // Squares next to the king of the side to move that the opponent attacks.
+  std::uint8_t king_zone_attacks;
+  std::uint8_t pinned_count;
+};
+
+inline constexpr auto MOBILITY_WEIGHTS = [] {
+  EnumMap<PieceType, std::int16_t> mobility_weights;
+  mobility_weights[PieceType::PAWN] = 0;
+  mobility_weights[PieceType::KNIGHT] = 4;
+  mobility_weights[PieceType::BISHOP] = 3;
+  mobility_weights[PieceType::ROOK] = 2;
+  mobility_weights[PieceType::QUEEN] = 1;
+  mobility_weights[PieceType::KING] = 0;
+  return mobility_weights;
+}();
+
+inline constexpr std::int16_t KING_ZONE_ATTACK_WEIGHT = -6;
+
+inline constexpr std::int16_t PIN_WEIGHT = -12;
+
+constexpr Bitboard king_zone(const Bitboard king) noexcept {
+  Bitboard king_zone{};
+  magic_enum::enum_for_each<Direction>([&](const auto direction) { king_zone |= shift(king, direction); });
+  return king_zone;
+}
+}  // namespace prodigy::evaluation
@@ -1,6 +1,8 @@
 export module prodigy.evaluation;
 
+export import :byproducts;
 export import :evaluator;
+export import :network;
 export import :phase;
 export import :piece_values;
 export import :psqt;
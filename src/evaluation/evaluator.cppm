@@ -2,138 +2,174 @@ module;
 
 #include <algorithm>
 #include <cstdint>
-#include <functional>
 #include <magic_enum/magic_enum_utility.hpp>
-#include <type_traits>
-#include <utility>
 
 export module prodigy.evaluation:evaluator;
 
 import prodigy.core;
 
+import :byproducts;
 import :phase;
 import :piece_values;
 import :psqt;
 
+export namespace prodigy::evaluation {
+// Whether evaluation and the rewards derived from it trade a little accuracy for speed.
+inline constexpr bool FAST_EVALUATION = PRODIGY_FAST_EVALUATION;
+}  // namespace prodigy::evaluation
+
+namespace prodigy::evaluation {
+// The midgame and endgame terms, white's minus black's, and the phase, packed into 16-bit lanes of one integer so that
+// each move updates all of them in a single addition. Lanes are signed and borrow from the lane above.
+using Score = std::int64_t;
+
+struct UnpackedScore {
+  std::int_fast32_t midgame;
+  std::int_fast32_t endgame;
+  std::int_fast32_t phase;
+};
+
+constexpr Score pack(const std::int_fast32_t midgame, const std::int_fast32_t endgame,
+                     const std::int_fast32_t phase) noexcept {
+  return midgame + endgame * (Score{1} << 16) + phase * (Score{1} << 32);
+}
+
+constexpr UnpackedScore unpack(Score score) noexcept {
+  const auto pop_lane = [&] {
+    const auto lane = static_cast<std::int16_t>(static_cast<std::uint16_t>(score));
+    score = (score - lane) >> 16;
+    return std::int_fast32_t{lane};
+  };
+  const auto midgame = pop_lane();
+  const auto endgame = pop_lane();
+  return {.midgame = midgame, .endgame = endgame, .phase = pop_lane()};
+}
+
+inline constexpr auto TABLES = [] {
+  EnumMap<PieceType, EnumMap<Color, EnumMap<Square, Score>>> tables;
+  magic_enum::enum_for_each<PieceType>([&](const auto piece_type) {
+    magic_enum::enum_for_each<Color>([&](const auto color) {
+      const auto sign = color == Color::WHITE ? 1 : -1;
+      magic_enum::enum_for_each<Square>([&](const auto square) {
+        const auto term = [&](const auto phase) {
+          return sign * (PSQT[phase][piece_type][color][square] + PIECE_VALUES[phase][piece_type]);
+        };
+        tables[piece_type][color][square] = pack(term(Phase::MIDGAME), term(Phase::ENDGAME), PHASE_DELTAS[piece_type]);
+      });
+    });
+  });
+  return tables;
+}();
+}  // namespace prodigy::evaluation
+
 export namespace prodigy::evaluation {
 class Evaluator {
  public:
   constexpr void on_search_start(const Board& board) noexcept {
-    base_state_ = State();
+    base_score_ = Score();
     magic_enum::enum_for_each<Color>([&](const auto color) {
       magic_enum::enum_for_each<PieceType>([&](const auto piece_type) {
-        for_each_square(board[color, piece_type], [&](const auto square) {
-          magic_enum::enum_for_each<Phase>(
-              [&](const auto phase) { base_state_.terms[phase][color] += TABLES[phase][piece_type][color][square]; });
-          base_state_.phase += PHASE_DELTAS[piece_type];
-        });
+        for_each_square(board[color, piece_type],
+                        [&](const auto square) { base_score_ += TABLES[piece_type][color][square]; });
       });
     });
   }
 
-  constexpr void on_simulation_start() noexcept { active_state_ = base_state_; }
+  constexpr void on_simulation_start() noexcept { active_score_ = base_score_; }
 
   template <Color side_to_move>
   constexpr void on_move(const QuietMove& move) noexcept {
-    update_square<side_to_move>(move.piece_type, square_of(move.origin), square_of(move.target));
+    const auto& table = TABLES[move.piece_type][side_to_move];
+    active_score_ += table[square_of(move.target)] - table[square_of(move.origin)];
   }
 
   template <Color side_to_move>
   constexpr void on_move(const Capture& move) noexcept {
+    const auto& table = TABLES[move.aggressor][side_to_move];
     const auto target = square_of(move.target);
-    update_square<side_to_move>(move.aggressor, square_of(move.origin), target);
-    remove<!side_to_move>(move.victim, target);
+    active_score_ += table[target] - table[square_of(move.origin)] - TABLES[move.victim][!side_to_move][target];
   }
 
   template <Color side_to_move>
   constexpr void on_move(const Castle& move) noexcept {
-    update_square<side_to_move>(PieceType::KING, square_of(move.king_origin), square_of(move.king_target));
-    update_square<side_to_move>(PieceType::KING, square_of(move.rook_origin), square_of(move.rook_target));
+    const auto& king_table = TABLES[PieceType::KING][side_to_move];
+    const auto& rook_table = TABLES[PieceType::ROOK][side_to_move];
+    active_score_ += king_table[square_of(move.king_target)] - king_table[square_of(move.king_origin)] +
+                     rook_table[square_of(move.rook_target)] - rook_table[square_of(move.rook_origin)];
   }
 
   template <Color side_to_move>
   constexpr void on_move(const QuietPromotion& move) noexcept {
-    remove<side_to_move>(PieceType::PAWN, square_of(move.origin));
-    add<side_to_move>(move.promotion, square_of(move.target));
+    active_score_ += TABLES[move.promotion][side_to_move][square_of(move.target)] -
+                     TABLES[PieceType::PAWN][side_to_move][square_of(move.origin)];
   }
 
   template <Color side_to_move>
   constexpr void on_move(const CapturePromotion& move) noexcept {
     const auto target = square_of(move.target);
-    remove<side_to_move>(PieceType::PAWN, square_of(move.origin));
-    remove<!side_to_move>(move.victim, target);
-    add<side_to_move>(move.promotion, target);
+    active_score_ += TABLES[move.promotion][side_to_move][target] -
+                     TABLES[PieceType::PAWN][side_to_move][square_of(move.origin)] -
+                     TABLES[move.victim][!side_to_move][target];
   }
 
   template <Color side_to_move>
   constexpr void on_move(const EnPassant& move) noexcept {
-    update_square<side_to_move>(PieceType::PAWN, square_of(move.origin), square_of(move.target));
-    remove<!side_to_move>(PieceType::PAWN, square_of(move.victim_origin));
+    const auto& table = TABLES[PieceType::PAWN][side_to_move];
+    active_score_ += table[square_of(move.target)] - table[square_of(move.origin)] -
+                     TABLES[PieceType::PAWN][!side_to_move][square_of(move.victim_origin)];
   }
 
   template <Color side_to_move>
   constexpr float evaluate() const noexcept {
     static constexpr Value MAX_PHASE = 24;
-    EnumMap<Phase, Value> evaluations;
-    magic_enum::enum_for_each<Phase>([&](const auto phase) {
-      evaluations[phase] = active_state_.terms[phase][side_to_move] - active_state_.terms[phase][!side_to_move];
-    });
-    const auto midgame_phase = std::min(active_state_.phase, MAX_PHASE);
+    const auto [midgame, endgame, phase] = unpack(active_score_);
+    const auto midgame_phase = std::min(phase, MAX_PHASE);
     const auto endgame_phase = MAX_PHASE - midgame_phase;
-    return static_cast<float>(evaluations[Phase::MIDGAME] * midgame_phase +
-                              evaluations[Phase::ENDGAME] * endgame_phase) /
-           MAX_PHASE;
+    const auto evaluation = static_cast<float>((midgame * midgame_phase + endgame * endgame_phase) *
+                                               (side_to_move == Color::WHITE ? 1 : -1));
+    if constexpr (FAST_EVALUATION) {
+      return evaluation * (1.0F / MAX_PHASE);
+    } else {
+      return evaluation / MAX_PHASE;
+    }
   }
 
  private:
   using Value = std::int_fast32_t;
 
-  struct State {
-    EnumMap<Phase, EnumMap<Color, Value>> terms;
-    Value phase;
-  };
-
-  template <Color color>
-  constexpr void for_each_term(const PieceType piece_type, auto&& callback) noexcept {
-    magic_enum::enum_for_each<Phase>([&](const auto phase) {
-      std::invoke(std::forward<decltype(callback)>(callback), active_state_.terms[phase][color],
-                  TABLES[phase][piece_type][color]);
-    });
-  }
+  Score base_score_;
+  Score active_score_;
+};
 
-  template <Color color>
-  constexpr void update_square(const PieceType piece_type, const Square origin, const Square target) noexcept {
-    for_each_term<color>(piece_type, [&](auto& term, const auto& table) { term += table[target] - table[origin]; });
+// Adds mobility, attacks on the king zone and pins to the leaf value, read off the byproducts of generating the leaf's
+// moves instead of a second attack pass. Unlike material and placement, these terms are not updated incrementally: a
+// move opens and closes slider rays anywhere on the board, so tracking them would cost an attack pass per move, whereas
+// expanding the leaf computes them anyway.
+class ByproductEvaluator : public Evaluator {
+ public:
+  constexpr void on_simulation_start() noexcept {
+    Evaluator::on_simulation_start();
+    byproducts_value_ = 0;
   }
 
-  template <Color color>
-  constexpr void add(const PieceType piece_type, const Square origin) noexcept {
-    for_each_term<color>(piece_type, [&](auto& term, const auto& table) { term += table[origin]; });
-    active_state_.phase += PHASE_DELTAS[piece_type];
+  template <Color side_to_move>
+  constexpr void on_byproducts(const Byproducts& byproducts) noexcept {
+    Value value = KING_ZONE_ATTACK_WEIGHT * byproducts.king_zone_attacks + PIN_WEIGHT * byproducts.pinned_count;
+    magic_enum::enum_for_each<PieceType>(
+        [&](const auto piece_type) { value += MOBILITY_WEIGHTS[piece_type] * byproducts.mobility[piece_type]; });
+    byproducts_value_ = side_to_move == Color::WHITE ? value : -value;
   }
 
-  template <Color color>
-  constexpr void remove(const PieceType piece_type, const Square origin) noexcept {
-    for_each_term<color>(piece_type, [&](auto& term, const auto& table) { term -= table[origin]; });
-    active_state_.phase -= PHASE_DELTAS[piece_type];
+  template <Color side_to_move>
+  constexpr float evaluate() const noexcept {
+    return Evaluator::evaluate<side_to_move>() +
+           static_cast<float>(side_to_move == Color::WHITE ? byproducts_value_ : -byproducts_value_);
   }
 
-  static constexpr auto TABLES = [] {
-    std::remove_const_t<decltype(PSQT)> tables;
-    magic_enum::enum_for_each<Phase>([&](const auto phase) {
-      magic_enum::enum_for_each<PieceType>([&](const auto piece_type) {
-        magic_enum::enum_for_each<Color>([&](const auto color) {
-          magic_enum::enum_for_each<Square>([&](const auto square) {
-            tables[phase][piece_type][color][square] =
-                PSQT[phase][piece_type][color][square] + PIECE_VALUES[phase][piece_type];
-          });
-        });
-      });
-    });
-    return tables;
-  }();
+ private:
+  using Value = std::int_fast32_t;
 
-  State base_state_;
-  State active_state_;
+  // From white's point of view, for the last node only since only leaves are evaluated.
+  Value byproducts_value_ = 0;
 };
 }  // namespace prodigy::evaluation
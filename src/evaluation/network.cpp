@@ -0,0 +1,59 @@
+module;
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <string_view>
+#include <vector>
+
+module prodigy.evaluation;
+
+namespace prodigy::evaluation {
+std::expected<Network, std::string_view> load_network(std::istream& stream) {
+  if constexpr (std::endian::native != std::endian::little) {
+    return std::unexpected("Networks are only supported on little-endian targets.");
+  }
+  const auto read = [&](auto* const data, const std::size_t count) {
+    stream.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count * sizeof(*data)));
+    return static_cast<bool>(stream);
+  };
+  static constexpr std::array<char, 8> MAGIC{'P', 'R', 'O', 'D', 'N', 'N', 'U', 'E'};
+  std::array<char, MAGIC.size()> magic;
+  if (!read(magic.data(), magic.size()) || magic != MAGIC) {
+    return std::unexpected("Not a network.");
+  }
+  std::uint32_t hidden_size;
+  if (!read(&hidden_size, 1)) {
+    return std::unexpected("Truncated network.");
+  }
+  if (hidden_size == 0 || hidden_size > Network::MAX_HIDDEN_SIZE || hidden_size % Network::LANE_COUNT != 0) {
+    return std::unexpected("Unsupported hidden size.");
+  }
+  Network network{.lane_count = hidden_size / Network::LANE_COUNT};
+  network.feature_weights.resize(Network::FEATURE_COUNT * network.lane_count);
+  network.feature_biases.resize(network.lane_count);
+  network.output_weights.resize(2 * network.lane_count);
+  if (!read(network.feature_weights.data(), network.feature_weights.size()) ||
+      !read(network.feature_biases.data(), network.feature_biases.size()) ||
+      !read(network.output_weights.data(), network.output_weights.size()) || !read(&network.output_bias, 1)) {
+    return std::unexpected("Truncated network.");
+  }
+  if (stream.peek() != std::istream::traits_type::eof()) {
+    return std::unexpected("Trailing data after network.");
+  }
+  return network;
+}
+
+std::expected<Network, std::string_view> load_network(const std::filesystem::path& path) {
+  std::ifstream stream(path, std::ios::binary);
+  if (!stream) {
+    return std::unexpected("Failed to open network.");
+  }
+  return load_network(stream);
+}
+}  // namespace prodigy::evaluation
@@ -0,0 +1,206 @@
+module;
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <istream>
+#include <magic_enum/magic_enum_utility.hpp>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+export module prodigy.evaluation:network;
+
+import prodigy.core;
+
+export namespace prodigy::evaluation {
+// A quantized network in the style of efficiently updatable neural networks. Piece-square features, seen from each
+// side's perspective, feed one hidden layer whose clipped activations, the side to move's and then the other side's,
+// feed the output. The hidden layer before activation only changes by a few weight rows per move, so evaluators keep
+// it as an accumulator instead of recomputing it.
+//
+// Files are little-endian: the magic "PRODNNUE", the hidden size as a uint32, then the int16 feature weights row by
+// row, the int16 feature biases, the int16 output weights and the int32 output bias.
+struct Network {
+  // Sixteen lanes fill an AVX2 register. Targets without AVX2 get the same kernels in narrower registers.
+  static constexpr auto LANE_COUNT = 16UZ;
+  using Lanes [[gnu::vector_size(LANE_COUNT * sizeof(std::int16_t))]] = std::int16_t;
+
+  // Six piece types of two colors, relative to the perspective, on 64 squares flipped for black's perspective.
+  static constexpr auto FEATURE_COUNT = 768UZ;
+  static constexpr auto MAX_HIDDEN_SIZE = 4096UZ;
+  // Activations are clipped to [0, ACTIVATION_SCALE] and output weights are multiplied by WEIGHT_SCALE, so an output of
+  // ACTIVATION_SCALE * WEIGHT_SCALE is OUTPUT_SCALE centipawns.
+  static constexpr std::int16_t ACTIVATION_SCALE = 255;
+  static constexpr std::int32_t WEIGHT_SCALE = 64;
+  static constexpr std::int32_t OUTPUT_SCALE = 400;
+
+  std::span<const Lanes> feature_weights_of(const std::size_t feature) const noexcept {
+    return std::span(feature_weights).subspan(feature * lane_count, lane_count);
+  }
+
+  // The hidden size divided by LANE_COUNT.
+  std::size_t lane_count;
+  std::vector<Lanes> feature_weights;
+  std::vector<Lanes> feature_biases;
+  std::vector<Lanes> output_weights;
+  std::int32_t output_bias;
+};
+
+[[nodiscard]] std::expected<Network, std::string_view> load_network(std::istream& stream);
+
+[[nodiscard]] std::expected<Network, std::string_view> load_network(const std::filesystem::path& path);
+
+constexpr std::size_t feature_index(const Color perspective, const Color color, const PieceType piece_type,
+                                    const Square square) noexcept {
+  const auto relative_square = std::to_underlying(square) ^ (perspective == Color::WHITE ? 0 : 56);
+  return ((color == perspective ? 0UZ : 6UZ) + std::to_underlying(piece_type)) * 64 +
+         static_cast<std::size_t>(relative_square);
+}
+}  // namespace prodigy::evaluation
+
+namespace prodigy::evaluation {
+using Lanes = Network::Lanes;
+using WideLanes [[gnu::vector_size(Network::LANE_COUNT * sizeof(std::int32_t))]] = std::int32_t;
+
+void add(const std::span<Lanes> accumulator, const std::span<const Lanes> weights) noexcept {
+  for (auto i = 0UZ; i < accumulator.size(); ++i) {
+    accumulator[i] += weights[i];
+  }
+}
+
+void subtract(const std::span<Lanes> accumulator, const std::span<const Lanes> weights) noexcept {
+  for (auto i = 0UZ; i < accumulator.size(); ++i) {
+    accumulator[i] -= weights[i];
+  }
+}
+
+void add_subtract(const std::span<Lanes> accumulator, const std::span<const Lanes> added,
+                  const std::span<const Lanes> subtracted) noexcept {
+  for (auto i = 0UZ; i < accumulator.size(); ++i) {
+    accumulator[i] += added[i] - subtracted[i];
+  }
+}
+
+constexpr Lanes clip(Lanes lanes) noexcept {
+  lanes &= lanes > 0;
+  const Lanes saturated = lanes > Network::ACTIVATION_SCALE;
+  return (lanes & ~saturated) | (Network::ACTIVATION_SCALE & saturated);
+}
+
+// Products are widened to 32 bits since activations times weights overflow 16.
+std::int32_t propagate(const std::span<const Lanes> accumulator, const std::span<const Lanes> weights) noexcept {
+  WideLanes sums{};
+  for (auto i = 0UZ; i < accumulator.size(); ++i) {
+    sums += __builtin_convertvector(clip(accumulator[i]), WideLanes) * __builtin_convertvector(weights[i], WideLanes);
+  }
+  std::int32_t sum = 0;
+  for (auto i = 0UZ; i < Network::LANE_COUNT; ++i) {
+    sum += sums[i];
+  }
+  return sum;
+}
+}  // namespace prodigy::evaluation
+
+export namespace prodigy::evaluation {
+// Same hooks as Evaluator, evaluating with a network through accumulators updated move by move.
+class NetworkEvaluator {
+ public:
+  // Must be assigned a network before use.
+  NetworkEvaluator() = default;
+
+  explicit NetworkEvaluator(std::shared_ptr<const Network> network) noexcept : network_(std::move(network)) {}
+
+  void on_search_start(const Board& board) {
+    magic_enum::enum_for_each<Color>([&](const auto perspective) {
+      auto& accumulator = base_accumulators_[perspective];
+      accumulator = network_->feature_biases;
+      magic_enum::enum_for_each<Color>([&](const auto color) {
+        magic_enum::enum_for_each<PieceType>([&](const auto piece_type) {
+          for_each_square(board[color, piece_type], [&](const auto square) {
+            add(accumulator, network_->feature_weights_of(feature_index(perspective, color, piece_type, square)));
+          });
+        });
+      });
+    });
+  }
+
+  // Copying into accumulators of the same size does not allocate.
+  void on_simulation_start() { active_accumulators_ = base_accumulators_; }
+
+  template <Color side_to_move>
+  void on_move(const QuietMove& move) noexcept {
+    move_piece(side_to_move, move.piece_type, square_of(move.origin), square_of(move.target));
+  }
+
+  template <Color side_to_move>
+  void on_move(const Capture& move) noexcept {
+    const auto target = square_of(move.target);
+    move_piece(side_to_move, move.aggressor, square_of(move.origin), target);
+    remove_piece(!side_to_move, move.victim, target);
+  }
+
+  template <Color side_to_move>
+  void on_move(const Castle& move) noexcept {
+    move_piece(side_to_move, PieceType::KING, square_of(move.king_origin), square_of(move.king_target));
+    move_piece(side_to_move, PieceType::ROOK, square_of(move.rook_origin), square_of(move.rook_target));
+  }
+
+  template <Color side_to_move>
+  void on_move(const QuietPromotion& move) noexcept {
+    replace_piece(side_to_move, PieceType::PAWN, square_of(move.origin), move.promotion, square_of(move.target));
+  }
+
+  template <Color side_to_move>
+  void on_move(const CapturePromotion& move) noexcept {
+    const auto target = square_of(move.target);
+    replace_piece(side_to_move, PieceType::PAWN, square_of(move.origin), move.promotion, target);
+    remove_piece(!side_to_move, move.victim, target);
+  }
+
+  template <Color side_to_move>
+  void on_move(const EnPassant& move) noexcept {
+    move_piece(side_to_move, PieceType::PAWN, square_of(move.origin), square_of(move.target));
+    remove_piece(!side_to_move, PieceType::PAWN, square_of(move.victim_origin));
+  }
+
+  template <Color side_to_move>
+  float evaluate() const noexcept {
+    static constexpr auto SCALE =
+        static_cast<float>(Network::OUTPUT_SCALE) / (Network::ACTIVATION_SCALE * Network::WEIGHT_SCALE);
+    const auto output_weights = std::span(network_->output_weights);
+    const auto output = network_->output_bias +
+                        propagate(active_accumulators_[side_to_move], output_weights.first(network_->lane_count)) +
+                        propagate(active_accumulators_[!side_to_move], output_weights.subspan(network_->lane_count));
+    return static_cast<float>(output) * SCALE;
+  }
+
+ private:
+  void move_piece(const Color color, const PieceType piece_type, const Square origin, const Square target) noexcept {
+    replace_piece(color, piece_type, origin, piece_type, target);
+  }
+
+  void replace_piece(const Color color, const PieceType removed, const Square origin, const PieceType added,
+                     const Square target) noexcept {
+    magic_enum::enum_for_each<Color>([&](const auto perspective) {
+      add_subtract(active_accumulators_[perspective],
+                   network_->feature_weights_of(feature_index(perspective, color, added, target)),
+                   network_->feature_weights_of(feature_index(perspective, color, removed, origin)));
+    });
+  }
+
+  void remove_piece(const Color color, const PieceType piece_type, const Square square) noexcept {
+    magic_enum::enum_for_each<Color>([&](const auto perspective) {
+      subtract(active_accumulators_[perspective],
+               network_->feature_weights_of(feature_index(perspective, color, piece_type, square)));
+    });
+  }
+
+  std::shared_ptr<const Network> network_;
+  EnumMap<Color, std::vector<Lanes>> base_accumulators_;
+  EnumMap<Color, std::vector<Lanes>> active_accumulators_;
+};
+}  // namespace prodigy::evaluation
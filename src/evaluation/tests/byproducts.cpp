@@ -0,0 +1,15 @@
+#include <catch2/catch_test_macros.hpp>
+
+import prodigy.core;
+import prodigy.evaluation;
+
+namespace prodigy::evaluation {
+namespace {
+TEST_CASE("king zone") {
+  STATIC_REQUIRE(king_zone(to_bitboard(Square::A1)) ==
+                 (to_bitboard(Square::A2) | to_bitboard(Square::B1) | to_bitboard(Square::B2)));
+  STATIC_REQUIRE(popcount(king_zone(to_bitboard(Square::E4))) == 8);
+  STATIC_REQUIRE(popcount(king_zone(to_bitboard(Square::H5))) == 5);
+}
+}  // namespace
+}  // namespace prodigy::evaluation
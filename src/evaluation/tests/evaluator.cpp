@@ -67,6 +67,12 @@ TEST_CASE("castle") {
                  evaluate("2kr1bnr/pppqpppp/2n1b3/3p4/4P3/3B1N2/PPPP1PPP/RNBQ1RK1 w - - 0 1"));
 }
 
+TEST_CASE("endgame castle") {
+  STATIC_REQUIRE(evaluate("r3k3/8/8/8/8/8/8/4K2R w Kq - 0 1", ColorTraits<Color::WHITE>::KINGSIDE_CASTLE,
+                          ColorTraits<Color::BLACK>::QUEENSIDE_CASTLE) ==
+                 evaluate("2kr4/8/8/8/8/8/8/5RK1 w - - 0 1"));
+}
+
 TEST_CASE("quiet promotion") {
   STATIC_REQUIRE(evaluate("8/P5k1/8/8/8/8/1K1p4/8 b - - 0 1",
                           QuietPromotion{
@@ -136,5 +142,27 @@ TEST_CASE("reset") {
     return evaluator.evaluate<Color::WHITE>();
   }());
 }
+
+TEST_CASE("byproducts") {
+  static constexpr auto evaluator = [] {
+    ByproductEvaluator evaluator;
+    evaluator.on_search_start(STARTING_POSITION.board);
+    evaluator.on_simulation_start();
+    Byproducts byproducts{};
+    byproducts.mobility[PieceType::KNIGHT] = 4;
+    byproducts.mobility[PieceType::QUEEN] = 3;
+    byproducts.king_zone_attacks = 2;
+    byproducts.pinned_count = 1;
+    evaluator.on_byproducts<Color::BLACK>(byproducts);
+    return evaluator;
+  }();
+  STATIC_REQUIRE(evaluator.evaluate<Color::BLACK>() == 4 * 4 + 3 * 1 - 2 * 6 - 12);
+  STATIC_REQUIRE(evaluator.evaluate<Color::WHITE>() == -evaluator.evaluate<Color::BLACK>());
+  STATIC_REQUIRE([] {
+    auto reset_evaluator = evaluator;
+    reset_evaluator.on_simulation_start();
+    return reset_evaluator.evaluate<Color::BLACK>();
+  }() == 0);
+}
 }  // namespace
 }  // namespace prodigy::evaluation
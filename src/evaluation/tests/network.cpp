@@ -0,0 +1,159 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <fstream>
+#include <ios>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+import prodigy.core;
+import prodigy.evaluation;
+
+namespace prodigy::evaluation {
+namespace {
+// tiny.nnue has 16 hidden neurons, all but three of them dead. From each perspective, they hold 4 times the material
+// of that side in pawns, 4 times the material of the other side, and the sum of the relative ranks of that side's
+// pawns. The side to move's material weighs 64, the other side's -64 and its pawn ranks 16.
+std::shared_ptr<const Network> tiny_network() {
+  static const auto network = std::make_shared<const Network>(load_network(TINY_NETWORK).value());
+  return network;
+}
+
+template <Color side_to_move>
+float on_moves(NetworkEvaluator& evaluator) noexcept {
+  return evaluator.evaluate<side_to_move>();
+}
+
+template <Color side_to_move>
+float on_moves(NetworkEvaluator& evaluator, const auto& move, const auto&... moves) noexcept {
+  evaluator.on_move<side_to_move>(move);
+  return on_moves<!side_to_move>(evaluator, moves...);
+}
+
+float evaluate(const std::string_view fen, const auto&... moves) {
+  const auto position = parse_fen(fen).value();
+  NetworkEvaluator evaluator(tiny_network());
+  evaluator.on_search_start(position.board);
+  evaluator.on_simulation_start();
+  switch (position.side_to_move) {
+    case Color::WHITE:
+      return on_moves<Color::WHITE>(evaluator, moves...);
+    case Color::BLACK:
+      return on_moves<Color::BLACK>(evaluator, moves...);
+  }
+}
+
+TEST_CASE("load") {
+  const auto network = tiny_network();
+  REQUIRE(network->lane_count == 1);
+  REQUIRE(network->feature_weights.size() == Network::FEATURE_COUNT);
+  REQUIRE(network->output_weights.size() == 2);
+  REQUIRE(network->output_bias == 0);
+}
+
+TEST_CASE("load errors") {
+  const auto load = [](const std::string& bytes) {
+    std::istringstream stream(bytes);
+    return load_network(stream).error();
+  };
+  REQUIRE(load_network("missing.nnue").error() == "Failed to open network.");
+  REQUIRE(load("") == "Not a network.");
+  REQUIRE(load("PRODNNUF") == "Not a network.");
+  REQUIRE(load("PRODNNUE") == "Truncated network.");
+  REQUIRE(load(std::string("PRODNNUE\x08\0\0\0", 12)) == "Unsupported hidden size.");
+  REQUIRE(load(std::string("PRODNNUE\x10\0\0\0", 12)) == "Truncated network.");
+  std::ostringstream bytes;
+  bytes << std::ifstream(TINY_NETWORK, std::ios::binary).rdbuf() << '\0';
+  REQUIRE(load(bytes.str()) == "Trailing data after network.");
+}
+
+TEST_CASE("evaluate") {
+  static constexpr auto SCALE = 400.0 / (255 * 64);
+  REQUIRE_THAT(evaluate("4k3/8/8/8/8/8/4P3/4K3 w - - 0 1"), Catch::Matchers::WithinAbs((64 * 4 + 16) * SCALE, 1e-5));
+  REQUIRE_THAT(evaluate("4k3/8/8/8/8/8/4P3/4K3 b - - 0 1"), Catch::Matchers::WithinAbs(-64 * 4 * SCALE, 1e-5));
+  REQUIRE_THAT(evaluate("4k3/4p3/8/8/8/8/8/4K3 b - - 0 1"), Catch::Matchers::WithinAbs((64 * 4 + 16) * SCALE, 1e-5));
+  REQUIRE_THAT(evaluate(STARTING_FEN), Catch::Matchers::WithinAbs(16 * 8 * SCALE, 1e-5));
+}
+
+TEST_CASE("quiet move") {
+  REQUIRE(evaluate(STARTING_FEN,
+                   QuietMove{
+                       .origin = to_bitboard(Square::E2),
+                       .target = to_bitboard(Square::E4),
+                       .piece_type = PieceType::PAWN,
+                   },
+                   QuietMove{
+                       .origin = to_bitboard(Square::B8),
+                       .target = to_bitboard(Square::C6),
+                       .piece_type = PieceType::KNIGHT,
+                   }) == evaluate("r1bqkbnr/pppppppp/2n5/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 1"));
+}
+
+TEST_CASE("capture") {
+  REQUIRE(evaluate("3qk3/8/8/8/8/8/8/3QK3 b - - 0 1", Capture{
+                                                          .origin = to_bitboard(Square::D8),
+                                                          .target = to_bitboard(Square::D1),
+                                                          .aggressor = PieceType::QUEEN,
+                                                          .victim = PieceType::QUEEN,
+                                                      }) == evaluate("4k3/8/8/8/8/8/8/3qK3 w - - 0 1"));
+}
+
+TEST_CASE("castle") {
+  REQUIRE(evaluate("r3k3/8/8/8/8/8/8/4K2R w Kq - 0 1", ColorTraits<Color::WHITE>::KINGSIDE_CASTLE,
+                   ColorTraits<Color::BLACK>::QUEENSIDE_CASTLE) == evaluate("2kr4/8/8/8/8/8/8/5RK1 w - - 0 1"));
+}
+
+TEST_CASE("quiet promotion") {
+  REQUIRE(evaluate("8/P5k1/8/8/8/8/1K1p4/8 b - - 0 1",
+                   QuietPromotion{
+                       .origin = to_bitboard(Square::D2),
+                       .target = to_bitboard(Square::D1),
+                       .promotion = PieceType::ROOK,
+                   },
+                   QuietPromotion{
+                       .origin = to_bitboard(Square::A7),
+                       .target = to_bitboard(Square::A8),
+                       .promotion = PieceType::QUEEN,
+                   }) == evaluate("Q7/6k1/8/8/8/8/1K6/3r4 b - - 0 1"));
+}
+
+TEST_CASE("capture promotion") {
+  REQUIRE(evaluate("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 0 1",
+                   CapturePromotion{
+                       .origin = to_bitboard(Square::D7),
+                       .target = to_bitboard(Square::C8),
+                       .promotion = PieceType::BISHOP,
+                       .victim = PieceType::BISHOP,
+                   }) == evaluate("rnBq1k1r/pp2bppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R b KQ - 0 1"));
+}
+
+TEST_CASE("en passant") {
+  REQUIRE(evaluate("rnbqkbnr/ppp1pppp/8/3P4/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1",
+                   QuietMove{
+                       .origin = to_bitboard(Square::E7),
+                       .target = to_bitboard(Square::E5),
+                       .piece_type = PieceType::PAWN,
+                   },
+                   EnPassant{
+                       .origin = to_bitboard(Square::D5),
+                       .target = to_bitboard(Square::E6),
+                       .victim_origin = to_bitboard(Square::E5),
+                   }) == evaluate("rnbqkbnr/ppp2ppp/4P3/8/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1"));
+}
+
+TEST_CASE("reset") {
+  NetworkEvaluator evaluator(tiny_network());
+  evaluator.on_search_start(parse_fen(KIWIPETE).value().board);
+  evaluator.on_simulation_start();
+  evaluator.on_move<Color::WHITE>(Capture{
+      .origin = to_bitboard(Square::F3),
+      .target = to_bitboard(Square::F6),
+      .aggressor = PieceType::QUEEN,
+      .victim = PieceType::KNIGHT,
+  });
+  evaluator.on_simulation_start();
+  REQUIRE(evaluator.evaluate<Color::WHITE>() == evaluate(KIWIPETE));
+}
+}  // namespace
+}  // namespace prodigy::evaluation
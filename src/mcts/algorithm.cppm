@@ -2,14 +2,17 @@ module;
 
 #include <algorithm>
 #include <atomic>
-#include <chrono>
+#include <barrier>
 #include <cstddef>
 #include <expected>
 #include <functional>
 #include <future>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <optional>
+#include <ranges>
+#include <span>
 #include <string_view>
 #include <thread>
 #include <type_traits>
@@ -28,22 +31,36 @@ import :tree;
 import :tree_policy;
 
 export namespace prodigy::mcts {
+struct SearchLimits {
+  std::optional<std::size_t> simulations;
+  // In plies. The search completes once every edge above this depth has been visited.
+  std::optional<std::size_t> max_depth;
+  // Completes the search once a root move is proven to win.
+  bool stop_on_mate = false;
+  // Root moves to search, all of them when empty. Ignored if it allows none.
+  std::function<bool(const Edge&)> is_root_edge_allowed;
+  // Makes the search reproducible for a number of threads. Searchers publish their statistics to each other after
+  // every this many simulations, and searches stop on these boundaries.
+  std::optional<SimulationCount> simulations_per_epoch;
+};
+
 template <RolloutPolicy RolloutPolicy, TreePolicy TreePolicy>
 class Algorithm {
  public:
   explicit Algorithm(const std::optional<std::size_t> threads, const std::size_t arena_bytes,
                      const std::function<RolloutPolicy()>& make_rollout_policy,
                      const std::function<TreePolicy()>& make_tree_policy)
-      : searchers_([&] {
+      : arena_bytes_per_searcher_(arena_bytes / std::max(threads.value_or(std::thread::hardware_concurrency()), 1UZ) /
+                                  Arena::ALIGNMENT * Arena::ALIGNMENT),
+        searchers_([&] {
           decltype(searchers_) searchers;
           searchers.reserve(std::max(threads.value_or(std::thread::hardware_concurrency()), 1UZ));
-          const auto arena_bytes_per_searcher =
-              arena_bytes / searchers.capacity() / Arena::ALIGNMENT * Arena::ALIGNMENT;
           for (auto i = 0UZ; i < searchers.capacity(); ++i) {
-            searchers.emplace_back(arena_bytes_per_searcher, make_rollout_policy(), make_tree_policy());
+            searchers.emplace_back(arena_bytes_per_searcher_, make_rollout_policy(), make_tree_policy());
           }
           return searchers;
         }()),
+        progress_(searchers_.size()),
         max_simulations_per_searcher_(
             std::min<std::common_type_t<std::size_t, SimulationCount>>(arena_bytes / (sizeof(Node) + sizeof(Edge) * 45),
                                                                        std::numeric_limits<SimulationCount>::max()) /
@@ -60,39 +77,105 @@ class Algorithm {
     static_cast<void>(join());
   }
 
+  // on_complete is called from a search thread once every searcher has finished, whether the search completed or was
+  // stopped.
   [[nodiscard]] std::expected<void, std::string_view> start(const Position& position,
-                                                            const std::optional<std::size_t> simulations) noexcept {
+                                                            const std::span<const Hash> history,
+                                                            const SearchLimits& limits,
+                                                            std::function<void()> on_complete = {}) noexcept {
+    if (search_state_.has_value()) {
+      return std::unexpected("Already searching.");
+    }
+    return start(std::make_unique<Tree>(position, history, limits.is_root_edge_allowed), limits,
+                 std::move(on_complete));
+  }
+
+  // Searches a tree made beforehand, such as one continuing an earlier search. The root edge filter is up to whoever
+  // made the tree, and depth limits need a fresh one, since they count the unvisited edges from the root down.
+  [[nodiscard]] std::expected<void, std::string_view> start(std::unique_ptr<Tree> new_tree, const SearchLimits& limits,
+                                                            std::function<void()> on_complete = {}) noexcept {
     if (search_state_.has_value()) {
       return std::unexpected("Already searching.");
     }
-    auto search_tree = std::make_unique<Tree>(position);
-    auto& [stop, tree, searches] = search_state_.emplace();
-    for (const auto simulations_per_searcher = simulations
+    auto& search_tree = *new_tree;
+    auto& [stop, completion, running_searcher_count, tree, epoch_barrier, is_stopped_at_epoch, searches] =
+        search_state_.emplace();
+    // Set before searching, since on_complete may be called before start returns.
+    tree = std::move(new_tree);
+    if (limits.simulations_per_epoch.has_value()) {
+      epoch_barrier.emplace(std::ssize(searchers_), EndEpoch{*this});
+    }
+    running_searcher_count = searchers_.size();
+    completion.max_depth = limits.max_depth;
+    completion.stop_on_mate = limits.stop_on_mate;
+    completion.unvisited_edge_count = std::ssize(search_tree.root().edges());
+    if (limits.max_depth.has_value() && search_tree.root().edges().empty()) {
+      completion.complete.test_and_set(std::memory_order_relaxed);
+    }
+    for (const auto simulations_per_searcher = limits.simulations
                                                    .transform([&](const auto simulations) {
                                                      return std::min<std::common_type_t<std::size_t, SimulationCount>>(
                                                          simulations / searchers_.size(),
                                                          max_simulations_per_searcher_);
                                                    })
                                                    .value_or(max_simulations_per_searcher_);
-         auto& searcher : searchers_) {
-      searches.push_back(std::async(std::launch::async, [&stop = std::as_const(stop), &search_tree = *search_tree,
-                                                         &searcher, simulations_per_searcher] {
-        searcher.search_until(search_tree, [&](const auto simulation_count) {
-          return stop.test(std::memory_order_relaxed) || simulation_count == simulations_per_searcher;
-        });
+         auto&& [searcher, progress] : std::views::zip(searchers_, progress_)) {
+      searches.push_back(std::async(std::launch::async, [&stop = std::as_const(stop), &completion,
+                                                         &running_searcher_count, &search_tree, &epoch_barrier,
+                                                         &is_stopped_at_epoch = std::as_const(is_stopped_at_epoch),
+                                                         &searcher, &progress, simulations_per_searcher,
+                                                         searcher_index = static_cast<std::size_t>(
+                                                             &searcher - searchers_.data()),
+                                                         simulations_per_epoch = limits.simulations_per_epoch,
+                                                         on_complete] {
+        if (simulations_per_epoch.has_value()) {
+          searcher.search_epochs_until(
+              search_tree, progress, completion, searcher_index, *simulations_per_epoch,
+              [&](const auto simulation_count) { return simulation_count == simulations_per_searcher; },
+              [&] {
+                epoch_barrier->arrive_and_wait();
+                return !is_stopped_at_epoch;
+              });
+        } else {
+          searcher.search_until(search_tree, progress, completion, [&](const auto simulation_count) {
+            return stop.test(std::memory_order_relaxed) || simulation_count == simulations_per_searcher;
+          });
+        }
+        if (running_searcher_count.fetch_sub(1, std::memory_order_acq_rel) == 1 && on_complete) {
+          on_complete();
+        }
       }));
     }
-    tree = std::move(search_tree);
     return {};
   }
 
-  [[nodiscard]] std::expected<bool, std::string_view> poll() const noexcept {
+  struct Progress {
+    const Tree& tree;
+    // Fraction of the searchers' arenas in use.
+    float arena_usage;
+    std::size_t max_depth;
+    // One per searcher.
+    std::span<const SearchProgress> searchers;
+  };
+
+  // A snapshot of the search, read without pausing the searchers, so statistics may be a few simulations apart.
+  [[nodiscard]] std::expected<Progress, std::string_view> progress() const noexcept {
     if (!search_state_.has_value()) {
       return std::unexpected("Not searching.");
     }
-    return std::ranges::all_of(search_state_->searches, [](const auto& search) {
-      return search.wait_for(std::chrono::steady_clock::duration::zero()) == std::future_status::ready;
-    });
+    auto arena_bytes = 0UZ;
+    auto max_depth = 0UZ;
+    for (const auto& progress : progress_) {
+      arena_bytes += progress.arena_bytes.load(std::memory_order_relaxed);
+      max_depth = std::max(max_depth, progress.max_depth.load(std::memory_order_relaxed));
+    }
+    const auto arena_capacity = arena_bytes_per_searcher_ * searchers_.size();
+    return Progress{
+        .tree = *search_state_->tree,
+        .arena_usage = static_cast<float>(arena_bytes) / static_cast<float>(arena_capacity),
+        .max_depth = max_depth,
+        .searchers = progress_,
+    };
   }
 
   [[nodiscard]] std::expected<void, std::string_view> stop() noexcept {
@@ -113,14 +196,38 @@ class Algorithm {
   }
 
  private:
+  // Runs on one searcher once all of them have finished an epoch, before any starts the next. Publishing in searcher
+  // order keeps the sums of rewards, and so the tree, reproducible.
+  struct EndEpoch {
+    void operator()() const noexcept {
+      for (auto& searcher : algorithm.searchers_) {
+        searcher.publish();
+      }
+      auto& search_state = *algorithm.search_state_;
+      search_state.is_stopped_at_epoch = search_state.stop.test(std::memory_order_relaxed) ||
+                                         search_state.completion.complete.test(std::memory_order_relaxed);
+    }
+
+    Algorithm& algorithm;
+  };
+
   struct SearchState {
     std::atomic_flag stop;
+    SearchCompletion completion;
+    std::atomic<std::size_t> running_searcher_count;
     std::unique_ptr<const Tree> tree;
+    // Deterministic searches only.
+    std::optional<std::barrier<EndEpoch>> epoch_barrier;
+    // Written by EndEpoch, so searchers read it once the barrier releases them.
+    bool is_stopped_at_epoch = false;
     std::vector<std::future<void>> searches;
   };
 
   std::optional<SearchState> search_state_;
+  const std::size_t arena_bytes_per_searcher_;
   std::vector<Searcher<RolloutPolicy, TreePolicy>> searchers_;
+  // One per searcher.
+  std::vector<SearchProgress> progress_;
   const SimulationCount max_simulations_per_searcher_;
 };
 
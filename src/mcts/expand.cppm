@@ -2,57 +2,87 @@ module;
 
 #include <cassert>
 #include <concepts>
+#include <cstdint>
 #include <limits>
 #include <utility>
 
 export module prodigy.mcts:expand;
 
 import prodigy.core;
+import prodigy.evaluation;
 import prodigy.move_generator;
 
 import :arena;
 import :tree;
 
 namespace prodigy::mcts {
-template <move_generator::Node::Context parent_context>
-class EdgeInserter : public move_generator::Visitor<EdgeInserter<parent_context>> {
+// Collects the byproducts of walking a node, for rollout policies that consume them.
+struct ByproductSink {
+  evaluation::Byproducts& byproducts;
+  move_generator::Constraints constraints{};
+};
+
+// Collects nothing, so that expanding for any other policy costs no more than inserting edges.
+struct NullSink {};
+
+template <move_generator::Node::Context parent_context, typename Sink = NullSink>
+class EdgeInserter : public move_generator::Visitor<EdgeInserter<parent_context, Sink>> {
  public:
-  explicit EdgeInserter(EdgeCount& edge_count, bool& is_check, Arena& arena) noexcept
-      : edge_count_(edge_count), is_check_(is_check), arena_(arena) {}
+  explicit EdgeInserter(EdgeCount& edge_count, bool& is_check, Sink& sink, Arena& arena) noexcept
+      : edge_count_(edge_count), is_check_(is_check), sink_(sink), arena_(arena) {}
 
   template <move_generator::Node::Context child_context>
   void visit_pawn_move(const auto& move) const noexcept {
+    count<PieceType::PAWN>();
     insert<child_context>(move);
   }
 
   template <move_generator::Node::Context child_context>
   void visit_knight_move(const auto& move) const noexcept {
+    count<PieceType::KNIGHT>();
     insert<child_context>(move);
   }
 
   template <move_generator::Node::Context child_context>
   void visit_bishop_move(const auto& move) const noexcept {
+    count<PieceType::BISHOP>();
     insert<child_context>(move);
   }
 
   template <move_generator::Node::Context child_context>
   void visit_rook_move(const auto& move) const noexcept {
+    count<PieceType::ROOK>();
     insert<child_context>(move);
   }
 
   template <move_generator::Node::Context child_context>
   void visit_queen_move(const auto& move) const noexcept {
+    count<PieceType::QUEEN>();
     insert<child_context>(move);
   }
 
   template <move_generator::Node::Context child_context>
   void visit_king_move(const auto& move) const noexcept {
+    count<PieceType::KING>();
     insert<child_context>(move);
   }
 
   void is_check() const noexcept { is_check_ = true; }
 
+  void visit_constraints(const move_generator::Constraints& constraints) const noexcept
+    requires std::same_as<Sink, ByproductSink>
+  {
+    sink_.constraints = constraints;
+  }
+
  private:
+  template <PieceType piece_type>
+  void count() const noexcept {
+    if constexpr (std::same_as<Sink, ByproductSink>) {
+      ++sink_.byproducts.mobility[piece_type];
+    }
+  }
+
   void insert(auto&&... args) const noexcept {
     assert(edge_count_ < std::numeric_limits<EdgeCount>::max());
     ++edge_count_;
@@ -78,14 +108,32 @@ class EdgeInserter : public move_generator::Visitor<EdgeInserter<parent_context>
 
   EdgeCount& edge_count_;
   bool& is_check_;
+  Sink& sink_;
   Arena& arena_;
 };
 
+// Also fills in the byproducts of walking the node, which cost a counter per edge and a few popcounts.
+template <move_generator::Node::Context context>
+Node& expand(const move_generator::Node& node, Arena& arena, evaluation::Byproducts& byproducts) noexcept {
+  EdgeCount edge_count = 0;
+  bool is_check = false;
+  byproducts = {};
+  ByproductSink sink{.byproducts = byproducts};
+  move_generator::walk<context>(node, EdgeInserter<context, ByproductSink>(edge_count, is_check, sink, arena));
+  const auto& board = node.board;
+  byproducts.king_zone_attacks = static_cast<std::uint8_t>(
+      popcount(evaluation::king_zone(board[context.side_to_move, PieceType::KING]) & sink.constraints.king_danger_set));
+  byproducts.pinned_count = static_cast<std::uint8_t>(
+      popcount((sink.constraints.dg_pin_mask | sink.constraints.hv_pin_mask) & board[context.side_to_move]));
+  return arena.new_object<Node>(edge_count, is_check);
+}
+
 template <move_generator::Node::Context context>
 Node& expand(const move_generator::Node& node, Arena& arena) noexcept {
   EdgeCount edge_count = 0;
   bool is_check = false;
-  move_generator::walk<context>(node, EdgeInserter<context>(edge_count, is_check, arena));
+  NullSink sink;
+  move_generator::walk<context>(node, EdgeInserter<context>(edge_count, is_check, sink, arena));
   return arena.new_object<Node>(edge_count, is_check);
 }
 }  // namespace prodigy::mcts
@@ -1,7 +1,10 @@
 module;
 
+#include <algorithm>
 #include <cmath>
 #include <concepts>
+#include <memory>
+#include <numbers>
 #include <utility>
 
 export module prodigy.mcts:rollout_policy;
@@ -29,6 +32,29 @@ concept RolloutPolicy = requires(const Position position) {
   } -> std::same_as<float>;
 };
 
+// Rollout policies may also define on_byproducts, which is then called with the byproducts of expanding each leaf
+// right before it is simulated.
+template <typename T>
+concept ByproductConsumer = requires(T rollout_policy, const evaluation::Byproducts byproducts) {
+  rollout_policy.template on_byproducts<Color::WHITE>(byproducts);
+};
+}  // namespace prodigy::mcts
+
+namespace prodigy::mcts {
+// Maps a centipawn evaluation to a reward in [-1, 1].
+float to_reward(const float evaluation) noexcept {
+  if constexpr (evaluation::FAST_EVALUATION) {
+    // The logistic below is tanh(evaluation * ln(10) / 800). Its Pade approximant is within 0.024 of it and reaches
+    // exactly 1 at 3, where it is clamped.
+    const auto x = std::clamp(evaluation * (std::numbers::ln10_v<float> / 800), -3.0F, 3.0F);
+    return x * (27 + x * x) / (27 + 9 * x * x);
+  } else {
+    return 2 / (1 + std::powf(10, evaluation / -400)) - 1;
+  }
+}
+}  // namespace prodigy::mcts
+
+export namespace prodigy::mcts {
 class EvaluationPolicy : private evaluation::Evaluator {
  public:
   using Evaluator::on_move;
@@ -37,7 +63,38 @@ class EvaluationPolicy : private evaluation::Evaluator {
 
   template <Color side_to_move>
   float simulate() const noexcept {
-    return 2 / (1 + std::powf(10, evaluate<side_to_move>() / -400)) - 1;
+    return to_reward(evaluate<side_to_move>());
+  }
+};
+
+class ByproductEvaluationPolicy : private evaluation::ByproductEvaluator {
+ public:
+  using ByproductEvaluator::on_byproducts;
+  using ByproductEvaluator::on_move;
+  using ByproductEvaluator::on_search_start;
+  using ByproductEvaluator::on_simulation_start;
+
+  template <Color side_to_move>
+  float simulate() const noexcept {
+    return to_reward(evaluate<side_to_move>());
+  }
+};
+
+class NetworkEvaluationPolicy : private evaluation::NetworkEvaluator {
+ public:
+  // Must be assigned a network before use.
+  NetworkEvaluationPolicy() = default;
+
+  explicit NetworkEvaluationPolicy(std::shared_ptr<const evaluation::Network> network) noexcept
+      : NetworkEvaluator(std::move(network)) {}
+
+  using NetworkEvaluator::on_move;
+  using NetworkEvaluator::on_search_start;
+  using NetworkEvaluator::on_simulation_start;
+
+  template <Color side_to_move>
+  float simulate() const noexcept {
+    return to_reward(evaluate<side_to_move>());
   }
 };
 }  // namespace prodigy::mcts
@@ -1,16 +1,25 @@
 module;
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <iterator>
+#include <optional>
 #include <ranges>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 export module prodigy.mcts:searcher;
 
 import prodigy.core;
+import prodigy.evaluation;
 import prodigy.move_generator;
 
 import :arena;
@@ -21,33 +30,185 @@ import :tree;
 import :tree_policy;
 
 export namespace prodigy::mcts {
+// Whether searchers count where their simulations spend their time.
+inline constexpr bool INSTRUMENTATION = PRODIGY_INSTRUMENTATION;
+
+enum class SearchCounter : std::uint8_t {
+  SIMULATIONS,
+  // Processor cycles from the root to the leaf, less expansions and rollouts.
+  DESCENT_CYCLES,
+  EXPANSION_CYCLES,
+  ROLLOUT_CYCLES,
+  BACKPROPAGATION_CYCLES,
+  EXPANSIONS,
+  // Expansions thrown away because another searcher created the child first.
+  EXPANSION_RACES,
+  // Plies from the root to the leaf, summed over simulations.
+  TOTAL_DEPTH,
+};
+
+// Zero unless instrumented.
+using SearchCounters = EnumMap<SearchCounter, std::atomic<std::uint64_t>>;
+
+// What a searcher publishes after each simulation for other threads to read while it searches. Aligned to keep the
+// searcher's stores off other searchers' cache lines.
+struct alignas(64) SearchProgress {
+  std::atomic<std::size_t> arena_bytes = 0;
+  // Plies from the root to the deepest node reached.
+  std::atomic<std::size_t> max_depth = 0;
+  SearchCounters counters;
+};
+
+// Shared by the searchers of a search to finish it before it is stopped.
+struct SearchCompletion {
+  // Nodes this many plies from the root are evaluated but not searched past, so the search completes once every edge
+  // above them has been visited.
+  std::optional<std::size_t> max_depth;
+  // Completes the search once a root edge is proven to win.
+  bool stop_on_mate = false;
+  // Must start at the number of root edges when there is a maximum depth.
+  std::atomic<std::ptrdiff_t> unvisited_edge_count = 0;
+  std::atomic_flag complete;
+};
+
 template <RolloutPolicy RolloutPolicy, TreePolicy TreePolicy>
 class alignas(64) Searcher {
  public:
   explicit Searcher(const std::size_t arena_bytes, RolloutPolicy&& rollout_policy, TreePolicy&& tree_policy)
       : arena_(arena_bytes), rollout_policy_(std::move(rollout_policy)), tree_policy_(std::move(tree_policy)) {
     path_.reserve(64);
+    hashes_.reserve(256);
   }
 
   void search_until(Tree& tree, std::invocable<SimulationCount> auto&& stop) noexcept {
+    SearchProgress progress;
+    SearchCompletion completion;
+    search_until(tree, progress, completion, std::forward<decltype(stop)>(stop));
+  }
+
+  // Searches until stopped or until the search completes.
+  void search_until(Tree& tree, SearchProgress& progress, SearchCompletion& completion,
+                    std::invocable<SimulationCount> auto&& stop) noexcept {
+    search(tree, progress, completion, false, [&](const auto& simulate) {
+      for (SimulationCount simulation_count = 0;
+           !completion.complete.test(std::memory_order_relaxed) &&
+           !std::invoke(std::forward<decltype(stop)>(stop), simulation_count);
+           ++simulation_count) {
+        simulate();
+      }
+    });
+  }
+
+  // Searches reproducibly for a given number of searchers. Each runs simulations_per_epoch simulations per epoch, or
+  // fewer in the last one, seeing only the statistics published before the epoch and its own. After each epoch, every
+  // searcher of the search calls end_epoch, which must wait for all of them, publish them in a fixed order and return
+  // whether to keep searching. Completion is up to end_epoch, and stop must answer the same for every searcher. The
+  // searcher index tells searchers apart, so they must have different ones.
+  void search_epochs_until(Tree& tree, SearchProgress& progress, SearchCompletion& completion,
+                           const std::size_t searcher_index, const SimulationCount simulations_per_epoch,
+                           std::invocable<SimulationCount> auto&& stop, std::invocable<> auto&& end_epoch) noexcept {
+    assert(simulations_per_epoch > 0);
+    searcher_index_ = searcher_index;
+    search(tree, progress, completion, true, [&](const auto& simulate) {
+      for (SimulationCount simulation_count = 0; !std::invoke(stop, simulation_count);) {
+        do {
+          simulate();
+        } while (++simulation_count % simulations_per_epoch != 0 && !std::invoke(stop, simulation_count));
+        if (!std::invoke(end_epoch)) {
+          return;
+        }
+      }
+    });
+  }
+
+  // Adds the simulations of the last epoch to the tree and propagates the proofs they found. Searchers of the search
+  // must all be waiting.
+  void publish() noexcept {
+    tree_->on_simulations_complete(pending_.front());
+    for (const auto& [node, offset] : pending_offsets_) {
+      for (auto&& [edge, pending] : std::views::zip(node->edges(), std::span(pending_).subspan(offset))) {
+        if (pending.simulation_count > 0 && edge.on_simulations_complete(pending) == 0 &&
+            completion_->max_depth.has_value()) {
+          on_edges_visited(1);
+        }
+      }
+    }
+    for (const auto& path : proven_paths_) {
+      propagate_proof(path);
+    }
+    pending_.assign(1, {});
+    pending_offsets_.clear();
+    proven_paths_.clear();
+  }
+
+ private:
+  void search(Tree& tree, SearchProgress& progress, SearchCompletion& completion, const bool is_deterministic,
+              auto&& run) noexcept {
+    tree_ = &tree;
+    progress_ = &progress;
+    completion_ = &completion;
+    is_deterministic_ = is_deterministic;
+    pending_.assign(1, {});
+    pending_offsets_.clear();
+    proven_paths_.clear();
     arena_.reset(arena_.size());
+    progress.arena_bytes.store(0, std::memory_order_relaxed);
+    progress.max_depth.store(0, std::memory_order_relaxed);
+    for (auto& counter : progress.counters) {
+      counter.store(0, std::memory_order_relaxed);
+    }
+    auto max_depth = 0UZ;
     rollout_policy_.on_search_start(tree.position().board);
+    hashes_.assign(tree.history().begin(), tree.history().end());
+    hashes_.push_back(tree.position().hash());
+    const auto root_hash_count = hashes_.size();
     move_generator::dispatch(tree.position(), [&]<auto context>(const auto& node) {
-      for (SimulationCount simulation_count = 0; !std::invoke(std::forward<decltype(stop)>(stop), simulation_count);
-           ++simulation_count) {
+      run([&] {
         rollout_policy_.on_simulation_start();
         path_ = {tree};
+        pending_path_.assign(1, 0);
         node_ = node;
+        hashes_.resize(root_hash_count);
+        halfmove_clock_ = std::to_underlying(tree.position().halfmove_clock);
+        is_proven_ = false;
+        if constexpr (INSTRUMENTATION) {
+          phase_cycles_ = 0;
+        }
+        const auto start_cycles = cycles();
         auto reward = traverse<context>(tree.root());
-        for (auto statistics : std::views::reverse(path_)) {
-          statistics.get().on_simulation_complete(reward);
+        const auto leaf_cycles = cycles();
+        if (is_proven_) {
+          if (is_deterministic_) {
+            proven_paths_.push_back(path_);
+          } else {
+            propagate_proof(path_);
+          }
+        }
+        for (auto depth = path_.size(); depth-- > 0;) {
+          if (is_deterministic_) {
+            auto& pending = pending_[pending_path_[depth]];
+            ++pending.simulation_count;
+            pending.cumulative_reward += reward;
+          } else if (path_[depth].get().on_simulation_complete(reward) == 0 && depth > 0 &&
+                     completion.max_depth.has_value()) {
+            // The root is not an edge, and only edges above the maximum depth are counted.
+            on_edges_visited(1);
+          }
           reward = -reward;
         }
-      }
+        progress.arena_bytes.store(arena_.size(), std::memory_order_relaxed);
+        if (path_.size() - 1 > max_depth) {
+          max_depth = path_.size() - 1;
+          progress.max_depth.store(max_depth, std::memory_order_relaxed);
+        }
+        count(SearchCounter::SIMULATIONS);
+        count(SearchCounter::DESCENT_CYCLES, leaf_cycles - start_cycles - phase_cycles_);
+        count(SearchCounter::BACKPROPAGATION_CYCLES, cycles() - leaf_cycles);
+        count(SearchCounter::TOTAL_DEPTH, path_.size() - 1);
+      });
     });
   }
 
- private:
   template <move_generator::Node::Context context>
   float traverse(Node& node) noexcept {
     assert(!path_.empty());
@@ -55,7 +216,8 @@ class alignas(64) Searcher {
     if (edges.empty()) {
       return node.is_check();
     }
-    Edge& edge = tree_policy_.select(path_.back().get().simulation_count(), edges);
+    Edge& edge =
+        is_deterministic_ ? select_pending(node) : tree_policy_.select(path_.back().get().simulation_count(), edges);
     return edge.visit_move<context.side_to_move>(visitor{
         [&](const auto& move, Edge::EnableEnPassant) { return traverse<context.enable_en_passant()>(edge, move); },
         [&](const auto& move, const CastlingRights child_castling_rights) {
@@ -78,11 +240,192 @@ class alignas(64) Searcher {
     if constexpr (child_context.can_en_passant) {
       node_.en_passant_victim_origin = move.target;
     }
+    if constexpr (move_generator::RUNTIME_CASTLING_RIGHTS) {
+      node_.castling_rights = move_generator::update_castling_rights(node_.castling_rights, move);
+    }
     rollout_policy_.template on_move<!child_context.side_to_move>(move);
-    const auto [child, created] =
-        edge.get_or_create_child([&] -> decltype(auto) { return expand<child_context>(node_, arena_); },
-                                 [&](const auto& node) { arena_.reset(sizeof(node) + node.edges().size_bytes()); });
-    return created ? rollout_policy_.template simulate<!child_context.side_to_move>() : traverse<child_context>(child);
+    halfmove_clock_ = resets_halfmove_clock(move) ? 0 : halfmove_clock_ + 1;
+    hashes_.push_back(move_generator::hash<child_context>(node_));
+    // Paths are unique in the tree, so a draw is a property of the edge and its child never needs to be created.
+    if (is_draw<child_context>()) {
+      return 0;
+    }
+    const auto depth = path_.size() - 1;
+    const auto is_depth_limit = completion_->max_depth.has_value() && depth >= *completion_->max_depth;
+    const auto [child, created] = edge.get_or_create_child(
+        [&] -> Node& {
+          count(SearchCounter::EXPANSIONS);
+          auto& node = run_phase(SearchCounter::EXPANSION_CYCLES, [&] -> decltype(auto) {
+            if constexpr (ByproductConsumer<RolloutPolicy>) {
+              return expand<child_context>(node_, arena_, byproducts_);
+            } else {
+              return expand<child_context>(node_, arena_);
+            }
+          });
+          // Counted before the child is published, so that no searcher visits its edges first.
+          if (completion_->max_depth.has_value() && !is_depth_limit) {
+            completion_->unvisited_edge_count.fetch_add(std::ssize(node.edges()), std::memory_order_relaxed);
+          }
+          return node;
+        },
+        [&](const auto& node) {
+          count(SearchCounter::EXPANSION_RACES);
+          if (completion_->max_depth.has_value() && !is_depth_limit) {
+            on_edges_visited(std::ssize(node.edges()));
+          }
+          arena_.reset(sizeof(node) + node.edges().size_bytes());
+        });
+    // Deterministic searches go by what they see, so a child another searcher created during the epoch is still new.
+    if (!(is_deterministic_ ? visible_statistics(depth).first == 0 : created)) {
+      if (!is_depth_limit || child.edges().empty()) {
+        return traverse<child_context>(child);
+      }
+      // Nodes at the depth limit are not searched past, so revisiting one repeats its evaluation.
+      const auto [simulation_count, cumulative_reward] = visible_statistics(depth);
+      return simulation_count == 0 ? 0 : cumulative_reward / static_cast<float>(simulation_count);
+    }
+    if (child.edges().empty() && child.is_check()) {
+      edge.prove(Proof::WIN);
+      is_proven_ = true;
+    }
+    if constexpr (ByproductConsumer<RolloutPolicy>) {
+      // Byproducts come from expanding the child, which another searcher may have done.
+      if (!created) {
+        count(SearchCounter::EXPANSIONS);
+        const auto& node = run_phase(SearchCounter::EXPANSION_CYCLES, [&] -> decltype(auto) {
+          return expand<child_context>(node_, arena_, byproducts_);
+        });
+        arena_.reset(sizeof(node) + node.edges().size_bytes());
+      }
+    }
+    return run_phase(SearchCounter::ROLLOUT_CYCLES, [&] {
+      if constexpr (ByproductConsumer<RolloutPolicy>) {
+        rollout_policy_.template on_byproducts<child_context.side_to_move>(byproducts_);
+      }
+      return rollout_policy_.template simulate<!child_context.side_to_move>();
+    });
+  }
+
+  // The last edge of the path was just proven to win. Going up, an edge is a loss if a reply wins and a win if every
+  // reply loses.
+  void propagate_proof(const std::span<const std::reference_wrapper<SimulationStatistics>> path) noexcept {
+    for (auto depth = path.size() - 1; depth > 1; --depth) {
+      const auto& edge = static_cast<const Edge&>(path[depth].get());
+      auto& parent = static_cast<Edge&>(path[depth - 1].get());
+      if (edge.proof() == Proof::WIN) {
+        parent.prove(Proof::LOSS);
+      } else if (std::ranges::all_of(parent.child()->edges(),
+                                     [](const auto& reply) { return reply.proof() == Proof::LOSS; })) {
+        parent.prove(Proof::WIN);
+      } else {
+        return;
+      }
+    }
+    if (completion_->stop_on_mate && static_cast<const Edge&>(path[1].get()).proof() == Proof::WIN) {
+      completion_->complete.test_and_set(std::memory_order_relaxed);
+    }
+  }
+
+  // Selects as if this searcher's pending statistics were published, and records where the edge's are. Searchers all
+  // see the same statistics when an epoch starts, so each visits its own unvisited edge first instead of the policy's.
+  Edge& select_pending(Node& node) noexcept {
+    const auto edges = node.edges();
+    const auto [it, inserted] = pending_offsets_.try_emplace(&node, pending_.size());
+    if (inserted) {
+      pending_.resize(pending_.size() + edges.size());
+    }
+    const auto offset = it->second;
+    const auto pending = std::span(pending_).subspan(offset, edges.size());
+    const auto is_unvisited = [&](const std::size_t i) {
+      return edges[i].simulation_count() + pending[i].simulation_count == 0;
+    };
+    auto index = 0UZ;
+    if (const auto unvisited_count =
+            static_cast<std::size_t>(std::ranges::count_if(std::views::iota(0UZ, edges.size()), is_unvisited));
+        unvisited_count > 0) {
+      for (auto skipped_count = searcher_index_ % unvisited_count; !is_unvisited(index) || skipped_count-- > 0;) {
+        ++index;
+      }
+    } else {
+      index = static_cast<std::size_t>(
+          &tree_policy_.select(visible_statistics(path_.size() - 1).first, edges, pending) - edges.data());
+    }
+    pending_path_.push_back(offset + index);
+    return edges[index];
+  }
+
+  // The simulation count and cumulative reward at a depth of the path, including pending ones.
+  std::pair<SimulationCount, float> visible_statistics(const std::size_t depth) const noexcept {
+    const auto& statistics = path_[depth].get();
+    std::pair visible(statistics.simulation_count(), statistics.cumulative_reward());
+    if (is_deterministic_) {
+      const auto& pending = pending_[pending_path_[depth]];
+      visible.first += pending.simulation_count;
+      visible.second += pending.cumulative_reward;
+    }
+    return visible;
+  }
+
+  // Zero unless instrumented, so that timing compiles out.
+  static std::uint64_t cycles() noexcept {
+    if constexpr (INSTRUMENTATION) {
+      return __builtin_readcyclecounter();
+    } else {
+      return 0;
+    }
+  }
+
+  // Does nothing unless instrumented. Counters have a single writer, so they are added to without a locked instruction.
+  void count(const SearchCounter counter, const std::uint64_t value = 1) noexcept {
+    if constexpr (INSTRUMENTATION) {
+      auto& total = progress_->counters[counter];
+      total.store(total.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+  }
+
+  // Runs the phase of the simulation, counting its cycles towards the counter and out of the descent when instrumented.
+  decltype(auto) run_phase(const SearchCounter counter, std::invocable<> auto&& phase) noexcept {
+    if constexpr (INSTRUMENTATION) {
+      const auto start_cycles = cycles();
+      decltype(auto) result = std::invoke(phase);
+      const auto phase_cycles = cycles() - start_cycles;
+      count(counter, phase_cycles);
+      phase_cycles_ += phase_cycles;
+      return result;
+    } else {
+      return std::invoke(phase);
+    }
+  }
+
+  void on_edges_visited(const std::ptrdiff_t edge_count) noexcept {
+    if (completion_->unvisited_edge_count.fetch_sub(edge_count, std::memory_order_relaxed) == edge_count) {
+      completion_->complete.test_and_set(std::memory_order_relaxed);
+    }
+  }
+
+  static constexpr bool resets_halfmove_clock(const auto& move) noexcept {
+    if constexpr (requires { move.piece_type; }) {
+      return move.piece_type == PieceType::PAWN;
+    } else {
+      return !std::derived_from<std::remove_cvref_t<decltype(move)>, Castle>;
+    }
+  }
+
+  // A single repetition is scored as a draw, as is usual in search: the side that repeated could repeat again. A move
+  // that mates wins even when it also completes fifty moves, so the rule costs a mate check on the rare nodes it reaches.
+  template <move_generator::Node::Context context>
+  bool is_draw() const noexcept {
+    const auto reversible_plies = std::min<std::size_t>(halfmove_clock_, hashes_.size() - 1);
+    for (auto plies = 4UZ; plies <= reversible_plies; plies += 2) {
+      if (hashes_[hashes_.size() - 1 - plies] == hashes_.back()) {
+        return true;
+      }
+    }
+    if (halfmove_clock_ >= 100) {
+      const auto constraints = move_generator::make_constraints<context.side_to_move>(node_.board);
+      return empty(constraints.checkers) || move_generator::count_moves<context>(node_, constraints) > 0;
+    }
+    return false;
   }
 
   Arena arena_;
@@ -90,5 +433,23 @@ class alignas(64) Searcher {
   const TreePolicy tree_policy_;
   std::vector<std::reference_wrapper<SimulationStatistics>> path_;
   move_generator::Node node_;
+  std::vector<Hash> hashes_;
+  int halfmove_clock_ = 0;
+  evaluation::Byproducts byproducts_;
+  Tree* tree_ = nullptr;
+  SearchProgress* progress_ = nullptr;
+  SearchCompletion* completion_ = nullptr;
+  bool is_proven_ = false;
+  bool is_deterministic_ = false;
+  std::size_t searcher_index_ = 0;
+  // Instrumented searches only. Cycles of the simulation spent in expansions and rollouts.
+  std::uint64_t phase_cycles_ = 0;
+  // Deterministic searches only. The root's pending statistics come first, then those of the edges of each node from
+  // its offset.
+  std::vector<PendingStatistics> pending_;
+  std::unordered_map<Node*, std::size_t> pending_offsets_;
+  // Indices in pending_ of the statistics in path_.
+  std::vector<std::size_t> pending_path_;
+  std::vector<std::vector<std::reference_wrapper<SimulationStatistics>>> proven_paths_;
 };
 }  // namespace prodigy::mcts
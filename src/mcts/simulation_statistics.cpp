@@ -13,11 +13,21 @@ float SimulationStatistics::cumulative_reward() const noexcept {
   return cumulative_reward_.load(std::memory_order_acquire);
 }
 
-void SimulationStatistics::on_simulation_complete(const float reward) noexcept {
+SimulationCount SimulationStatistics::on_simulation_complete(const float reward) noexcept {
   // NOTE: updating statistics as a whole isn't atomic, which should only have a small effect and be tolerable.
-  simulation_count_.fetch_add(1, std::memory_order_release);
+  const auto simulation_count = simulation_count_.fetch_add(1, std::memory_order_release);
   for (auto expected = cumulative_reward_.load(std::memory_order_relaxed);
        !cumulative_reward_.compare_exchange_weak(expected, expected + reward, std::memory_order_release);) {
   }
+  return simulation_count;
+}
+
+SimulationCount SimulationStatistics::on_simulations_complete(const PendingStatistics& pending) noexcept {
+  const auto simulation_count = simulation_count_.fetch_add(pending.simulation_count, std::memory_order_release);
+  for (auto expected = cumulative_reward_.load(std::memory_order_relaxed);
+       !cumulative_reward_.compare_exchange_weak(expected, expected + pending.cumulative_reward,
+                                                 std::memory_order_release);) {
+  }
+  return simulation_count;
 }
 }  // namespace prodigy::mcts
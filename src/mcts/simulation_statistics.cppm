@@ -8,13 +8,23 @@ export module prodigy.mcts:simulation_statistics;
 export namespace prodigy::mcts {
 using SimulationCount = std::uint32_t;
 
+// Simulations a searcher has run but not yet added to the shared statistics.
+struct PendingStatistics {
+  SimulationCount simulation_count = 0;
+  float cumulative_reward = 0;
+};
+
 class SimulationStatistics {
  public:
   SimulationCount simulation_count() const noexcept;
 
   float cumulative_reward() const noexcept;
 
-  void on_simulation_complete(float reward) noexcept;
+  // Returns the simulation count before this simulation.
+  SimulationCount on_simulation_complete(float reward) noexcept;
+
+  // Returns the simulation count before these simulations.
+  SimulationCount on_simulations_complete(const PendingStatistics&) noexcept;
 
  private:
   std::atomic<SimulationCount> simulation_count_ = 0;
@@ -1,5 +1,12 @@
+#include <algorithm>
+#include <atomic>
 #include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <functional>
+#include <memory>
 #include <optional>
+#include <span>
+#include <vector>
 
 import prodigy.core;
 import prodigy.mcts;
@@ -16,51 +23,73 @@ TEST_CASE("start") {
 
   SECTION("simulations specified") {
     static constexpr auto simulations = threads * 1'000;
-    REQUIRE(algorithm.start(position, simulations).has_value());
+    REQUIRE(algorithm.start(position, {}, {.simulations = simulations}).has_value());
     const auto tree = algorithm.join().value();
     REQUIRE(tree != nullptr);
     REQUIRE(tree->simulation_count() == simulations);
   }
 
-  SECTION("max simulations") {
-    static constexpr auto simulations = std::numeric_limits<SimulationCount>::max();
-    STATIC_REQUIRE(simulations > arena_bytes);
-    REQUIRE(algorithm.start(position, simulations).has_value());
-    const auto tree = algorithm.join().value();
-    REQUIRE(tree != nullptr);
-    REQUIRE(tree->simulation_count() < simulations);
+  SECTION("on complete") {
+    static constexpr auto simulations = threads * 1'000;
+    std::atomic<int> completions = 0;
+    REQUIRE(algorithm
+                .start(position, {}, {.simulations = simulations},
+                       [&] {
+                         ++completions;
+                         completions.notify_all();
+                       })
+                .has_value());
+    completions.wait(0);
+    REQUIRE(algorithm.join().value()->simulation_count() == simulations);
+    REQUIRE(completions == 1);
   }
 
-  SECTION("simulations unspecified") {
-    REQUIRE(algorithm.start(position, std::nullopt).has_value());
+  SECTION("on complete when stopped") {
+    std::atomic_flag completed;
+    REQUIRE(algorithm
+                .start(position, {}, {},
+                       [&] {
+                         completed.test_and_set();
+                         completed.notify_all();
+                       })
+                .has_value());
     REQUIRE(algorithm.stop().has_value());
+    completed.wait(false);
     REQUIRE(algorithm.join().value() != nullptr);
   }
 
-  SECTION("poll without searching") {
-    const auto result = algorithm.poll();
-    REQUIRE_FALSE(result.has_value());
-    REQUIRE(result.error() == "Not searching.");
+  SECTION("reused tree") {
+    static constexpr auto simulations = threads * 1'000;
+    REQUIRE(algorithm.start(position, {}, {.simulations = simulations}).has_value());
+    const auto last_tree = algorithm.join().value();
+    const auto& edge = *std::ranges::max_element(last_tree->root().edges(), std::less(), &Edge::simulation_count);
+    const auto child_position = last_tree->play(edge);
+    REQUIRE(last_tree->find(child_position, 2) == std::vector{&edge});
+    auto tree = std::make_unique<Tree>(child_position, std::span<const Hash>(), edge);
+    REQUIRE(tree->position() == child_position);
+    REQUIRE(tree->simulation_count() == edge.simulation_count());
+    REQUIRE(std::ranges::equal(tree->root().edges(), edge.child()->edges(), std::equal_to(),
+                               &Edge::simulation_count, &Edge::simulation_count));
+    const auto& reply = *std::ranges::max_element(edge.child()->edges(), std::less(), &Edge::simulation_count);
+    const auto& reply_copy = tree->root().edges()[static_cast<std::size_t>(&reply - edge.child()->edges().data())];
+    REQUIRE(last_tree->find(tree->play(reply_copy), 2) == std::vector{&edge, &reply});
+    const auto reused_simulations = tree->simulation_count();
+    REQUIRE(algorithm.start(std::move(tree), {.simulations = simulations}).has_value());
+    REQUIRE(algorithm.join().value()->simulation_count() == reused_simulations + simulations);
   }
 
-  SECTION("poll without stop") {
-    static constexpr auto simulations = threads * 1'000;
-    REQUIRE(algorithm.start(position, simulations).has_value());
-    while (!algorithm.poll().value()) {
-    }
-    REQUIRE(algorithm.poll().value());
+  SECTION("max simulations") {
+    static constexpr auto simulations = std::numeric_limits<SimulationCount>::max();
+    STATIC_REQUIRE(simulations > arena_bytes);
+    REQUIRE(algorithm.start(position, {}, {.simulations = simulations}).has_value());
     const auto tree = algorithm.join().value();
     REQUIRE(tree != nullptr);
-    REQUIRE(tree->simulation_count() == simulations);
+    REQUIRE(tree->simulation_count() < simulations);
   }
 
-  SECTION("stop between poll") {
-    REQUIRE(algorithm.start(position, std::nullopt).has_value());
-    REQUIRE(algorithm.poll().has_value());
+  SECTION("simulations unspecified") {
+    REQUIRE(algorithm.start(position, {}, {}).has_value());
     REQUIRE(algorithm.stop().has_value());
-    while (!algorithm.poll().value()) {
-    }
-    REQUIRE(algorithm.poll().value());
     REQUIRE(algorithm.join().value() != nullptr);
   }
 
@@ -71,7 +100,7 @@ TEST_CASE("start") {
   }
 
   SECTION("multiple stops") {
-    REQUIRE(algorithm.start(position, std::nullopt).has_value());
+    REQUIRE(algorithm.start(position, {}, {}).has_value());
     REQUIRE(algorithm.stop().has_value());
     REQUIRE(algorithm.stop().has_value());
     REQUIRE(algorithm.join().value() != nullptr);
@@ -83,7 +112,22 @@ TEST_CASE("start") {
     REQUIRE(result.error() == "Not searching.");
   }
 
-  REQUIRE(algorithm.start(position, std::nullopt).has_value());
+  REQUIRE(algorithm.start(position, {}, {}).has_value());
+}
+
+TEST_CASE("deterministic") {
+  static constexpr auto threads = 4UZ;
+  static constexpr auto simulations = threads * 1'000;
+  static_cast<void>(move_generator::init());
+  Algorithm algorithm(threads, 1UZ << 30, [] { return EvaluationPolicy(); }, [] { return UCTPolicy(2); });
+  const auto search = [&] {
+    REQUIRE(algorithm.start(parse_fen(KIWIPETE).value(), {}, {.simulations = simulations, .simulations_per_epoch = 64})
+                .has_value());
+    const auto tree = algorithm.join().value();
+    REQUIRE(tree->simulation_count() == simulations);
+    return tree->signature();
+  };
+  REQUIRE(search() == search());
 }
 }  // namespace
 }  // namespace prodigy::mcts
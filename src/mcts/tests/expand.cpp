@@ -0,0 +1,26 @@
+#include <catch2/catch_test_macros.hpp>
+
+import prodigy.core;
+import prodigy.evaluation;
+import prodigy.mcts;
+import prodigy.move_generator;
+
+namespace prodigy::mcts {
+namespace {
+TEST_CASE("byproducts") {
+  static_cast<void>(move_generator::init());
+  move_generator::dispatch(parse_fen("4r1k1/8/8/8/8/8/4R3/4K3 w - - 0 1").value(), [&]<auto context>(const auto& node) {
+    Arena arena(1 << 16);
+    evaluation::Byproducts byproducts;
+    const auto& expanded_node = expand<context>(node, arena, byproducts);
+    REQUIRE(expanded_node.edges().size() == 10);
+    evaluation::Byproducts expected_byproducts{};
+    expected_byproducts.mobility[PieceType::ROOK] = 6;
+    expected_byproducts.mobility[PieceType::KING] = 4;
+    REQUIRE(byproducts.mobility == expected_byproducts.mobility);
+    REQUIRE(byproducts.king_zone_attacks == 1);
+    REQUIRE(byproducts.pinned_count == 1);
+  });
+}
+}  // namespace
+}  // namespace prodigy::mcts
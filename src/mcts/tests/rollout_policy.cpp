@@ -1,15 +1,18 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <memory>
 
 import prodigy.core;
+import prodigy.evaluation;
 import prodigy.mcts;
 
 namespace prodigy::mcts {
 namespace {
 template <Color side_to_move>
-void simulate(const EvaluationPolicy& rollout_policy, const float expected_reward) noexcept {
-  REQUIRE_THAT(rollout_policy.simulate<side_to_move>(), Catch::Matchers::WithinAbs(expected_reward, 0.00001));
-  REQUIRE_THAT(rollout_policy.simulate<!side_to_move>(), Catch::Matchers::WithinAbs(-expected_reward, 0.00001));
+void simulate(const auto& rollout_policy, const float expected_reward) noexcept {
+  static constexpr auto margin = evaluation::FAST_EVALUATION ? 0.024 : 0.00001;
+  REQUIRE_THAT(rollout_policy.template simulate<side_to_move>(), Catch::Matchers::WithinAbs(expected_reward, margin));
+  REQUIRE_THAT(rollout_policy.template simulate<!side_to_move>(), Catch::Matchers::WithinAbs(-expected_reward, margin));
 }
 
 TEST_CASE("evaluation policy") {
@@ -61,5 +64,42 @@ TEST_CASE("evaluation policy") {
   });
   simulate<Color::BLACK>(rollout_policy, -0.99577);
 }
+
+TEST_CASE("byproduct evaluation policy") {
+  STATIC_REQUIRE(RolloutPolicy<ByproductEvaluationPolicy>);
+  STATIC_REQUIRE(ByproductConsumer<ByproductEvaluationPolicy>);
+  STATIC_REQUIRE_FALSE(ByproductConsumer<EvaluationPolicy>);
+  ByproductEvaluationPolicy rollout_policy;
+  rollout_policy.on_search_start(STARTING_POSITION.board);
+  rollout_policy.on_simulation_start();
+  evaluation::Byproducts byproducts{};
+  byproducts.mobility[PieceType::KNIGHT] = 4;
+  byproducts.mobility[PieceType::PAWN] = 16;
+  rollout_policy.on_byproducts<Color::WHITE>(byproducts);
+  simulate<Color::WHITE>(rollout_policy, 0.04602);
+  rollout_policy.on_simulation_start();
+  simulate<Color::WHITE>(rollout_policy, 0);
+}
+
+TEST_CASE("network evaluation policy") {
+  STATIC_REQUIRE(RolloutPolicy<NetworkEvaluationPolicy>);
+  static constexpr auto margin = evaluation::FAST_EVALUATION ? 0.024 : 0.00001;
+  NetworkEvaluationPolicy rollout_policy(
+      std::make_shared<const evaluation::Network>(evaluation::load_network(TINY_NETWORK).value()));
+  rollout_policy.on_search_start(STARTING_POSITION.board);
+  rollout_policy.on_simulation_start();
+  // The tiny network rewards the side to move for the ranks its pawns have advanced, the same for both sides here.
+  REQUIRE_THAT(rollout_policy.simulate<Color::WHITE>(), Catch::Matchers::WithinAbs(0.00903, margin));
+  REQUIRE_THAT(rollout_policy.simulate<Color::BLACK>(), Catch::Matchers::WithinAbs(0.00903, margin));
+  rollout_policy.on_move<Color::WHITE>(Capture{
+      .origin = to_bitboard(Square::B1),
+      .target = to_bitboard(Square::B8),
+      .aggressor = PieceType::KNIGHT,
+      .victim = PieceType::KNIGHT,
+  });
+  REQUIRE(rollout_policy.simulate<Color::BLACK>() < 0);
+  rollout_policy.on_simulation_start();
+  REQUIRE_THAT(rollout_policy.simulate<Color::BLACK>(), Catch::Matchers::WithinAbs(0.00903, margin));
+}
 }  // namespace
 }  // namespace prodigy::mcts
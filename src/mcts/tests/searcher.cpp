@@ -1,12 +1,17 @@
+#include <algorithm>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 #include <cmath>
+#include <format>
+#include <iterator>
 #include <map>
+#include <set>
 #include <sstream>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 import prodigy.core;
 import prodigy.mcts;
@@ -90,6 +95,12 @@ TEST_CASE("search") {
     }
     return search_results;
   });
+  // Reported on failure in the table's format, to paste in when a change to the search is meant to change the results.
+  std::ostringstream actual_search_results;
+  for (const auto& [move, statistics] : search_results) {
+    actual_search_results << std::format("{{\"{}\", {{{}, {:.6g}}}}}, ", move, statistics.first, statistics.second);
+  }
+  INFO(actual_search_results.str());
   for (const auto& [move, statistics] : search_results) {
     INFO(move);
     const auto it = expected_search_results.find(move);
@@ -99,5 +110,119 @@ TEST_CASE("search") {
     CHECK_THAT(statistics.second, Catch::Matchers::WithinRel(expected_cumulative_reward, 0.001f));
   }
 }
+
+TEST_CASE("draws") {
+  const auto [fen, history, drawn_moves] =
+      GENERATE(table<std::string_view, std::vector<Hash>, std::set<std::string>>({
+          {
+              "4k3/8/8/8/8/8/8/R3K3 w - - 99 80",
+              {},
+              {"a1a2", "a1a3", "a1a4", "a1a5", "a1a6", "a1a7", "a1a8", "a1b1", "a1c1", "a1d1", "e1d1", "e1d2",
+               "e1e2", "e1f1", "e1f2"},
+          },
+          {
+              "k7/8/1K6/8/8/8/8/7R w - - 99 80",
+              {},
+              {"h1h2", "h1h3", "h1h4", "h1h5", "h1h6", "h1h7", "h1a1", "h1b1", "h1c1", "h1d1", "h1e1", "h1f1", "h1g1",
+               "b6a5", "b6b5", "b6c5", "b6a6", "b6c6", "b6c7"},
+          },
+          {
+              "4k3/8/8/8/8/8/8/R3K3 w - - 3 80",
+              {parse_fen("4k3/8/8/8/8/8/R7/4K3 b - - 0 78").value().hash(), Hash{1}, Hash{2}},
+              {"a1a2"},
+          },
+      }));
+  static constexpr SimulationCount simulations = 1 << 12;
+  static_cast<void>(move_generator::init());
+  Searcher searcher(1 << 26, EvaluationPolicy(), UCTPolicy(3 * std::sqrtf(2)));
+  const auto position = parse_fen(fen).value();
+  Tree tree(position, history);
+  searcher.search_until(tree, [](const auto simulation_count) { return simulation_count == simulations; });
+  for (const auto& edge : tree.root().edges()) {
+    edge.visit_move<Color::WHITE>([&](const auto& move, auto&&...) {
+      const auto uci_move = (std::ostringstream() << uci::to_move(move)).str();
+      INFO(uci_move);
+      REQUIRE(edge.simulation_count() > 0);
+      REQUIRE((edge.cumulative_reward() == 0) == drawn_moves.contains(uci_move));
+    });
+  }
+}
+
+TEST_CASE("max depth") {
+  static_cast<void>(move_generator::init());
+  Searcher searcher(1 << 26, EvaluationPolicy(), UCTPolicy(3 * std::sqrtf(2)));
+  Tree tree(STARTING_POSITION);
+  SearchProgress progress;
+  SearchCompletion completion{.max_depth = 2};
+  completion.unvisited_edge_count = std::ssize(tree.root().edges());
+  searcher.search_until(tree, progress, completion,
+                        [](const auto simulation_count) { return simulation_count == 1 << 20; });
+  REQUIRE(completion.complete.test());
+  REQUIRE(progress.max_depth == 2);
+  // Every simulation visits a new edge until all 20 root edges and 400 replies have been visited.
+  REQUIRE(tree.simulation_count() >= 420);
+  REQUIRE(tree.simulation_count() < 1 << 20);
+  for (const auto& edge : tree.root().edges()) {
+    REQUIRE(edge.child() != nullptr);
+    REQUIRE(std::ranges::all_of(edge.child()->edges(), [](const auto& reply) { return reply.simulation_count() > 0; }));
+  }
+}
+
+TEST_CASE("proofs") {
+  static_cast<void>(move_generator::init());
+  Searcher searcher(1 << 26, EvaluationPolicy(), UCTPolicy(3 * std::sqrtf(2)));
+  const auto position = parse_fen("6k1/5ppp/8/8/8/8/8/R3K3 w - - 0 1").value();
+  Tree tree(position);
+  SearchProgress progress;
+  SearchCompletion completion{.stop_on_mate = true};
+  searcher.search_until(tree, progress, completion,
+                        [](const auto simulation_count) { return simulation_count == 1 << 20; });
+  REQUIRE(completion.complete.test());
+  REQUIRE(tree.simulation_count() <= tree.root().edges().size());
+  for (const auto& edge : tree.root().edges()) {
+    edge.visit_move<Color::WHITE>([&](const auto& move, auto&&...) {
+      const auto uci_move = (std::ostringstream() << uci::to_move(move)).str();
+      INFO(uci_move);
+      REQUIRE((edge.proof() == Proof::WIN) == (uci_move == "a1a8"));
+    });
+  }
+}
+
+TEST_CASE("counters") {
+  static_cast<void>(move_generator::init());
+  Searcher searcher(1 << 26, EvaluationPolicy(), UCTPolicy(3 * std::sqrtf(2)));
+  Tree tree(STARTING_POSITION);
+  SearchProgress progress;
+  SearchCompletion completion;
+  static constexpr SimulationCount simulations = 1000;
+  searcher.search_until(tree, progress, completion,
+                        [](const auto simulation_count) { return simulation_count == simulations; });
+  const auto counter = [&](const SearchCounter search_counter) { return progress.counters[search_counter].load(); };
+  if constexpr (INSTRUMENTATION) {
+    REQUIRE(counter(SearchCounter::SIMULATIONS) == simulations);
+    // Simulations expand at most one node each, short of draws and leaves, and a single searcher has no one to race.
+    REQUIRE(counter(SearchCounter::EXPANSIONS) > 0);
+    REQUIRE(counter(SearchCounter::EXPANSIONS) <= simulations);
+    REQUIRE(counter(SearchCounter::EXPANSION_RACES) == 0);
+    REQUIRE(counter(SearchCounter::TOTAL_DEPTH) >= simulations);
+    REQUIRE(counter(SearchCounter::TOTAL_DEPTH) <= simulations * progress.max_depth);
+  } else {
+    for (const auto& total : progress.counters) {
+      REQUIRE(total == 0);
+    }
+  }
+}
+
+TEST_CASE("signature") {
+  static_cast<void>(move_generator::init());
+  const auto search = [](const SimulationCount simulations) {
+    Searcher searcher(1 << 26, EvaluationPolicy(), UCTPolicy(3 * std::sqrtf(2)));
+    Tree tree(parse_fen(KIWIPETE).value());
+    searcher.search_until(tree, [&](const auto simulation_count) { return simulation_count == simulations; });
+    return tree.signature();
+  };
+  REQUIRE(search(1 << 12) == search(1 << 12));
+  REQUIRE(search(1 << 12) != search((1 << 12) + 1));
+}
 }  // namespace
 }  // namespace prodigy::mcts
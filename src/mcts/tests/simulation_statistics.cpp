@@ -8,15 +8,24 @@ TEST_CASE("on_simulation_complete") {
   SimulationStatistics statistics;
   REQUIRE(statistics.simulation_count() == 0);
   REQUIRE(statistics.cumulative_reward() == 0);
-  statistics.on_simulation_complete(0);
+  REQUIRE(statistics.on_simulation_complete(0) == 0);
   REQUIRE(statistics.simulation_count() == 1);
   REQUIRE(statistics.cumulative_reward() == 0);
-  statistics.on_simulation_complete(1);
+  REQUIRE(statistics.on_simulation_complete(1) == 1);
   REQUIRE(statistics.simulation_count() == 2);
   REQUIRE(statistics.cumulative_reward() == 1);
-  statistics.on_simulation_complete(0.234567);
+  REQUIRE(statistics.on_simulation_complete(0.234567) == 2);
   REQUIRE(statistics.simulation_count() == 3);
   REQUIRE(statistics.cumulative_reward() == 1.234567f);
 }
+
+TEST_CASE("on_simulations_complete") {
+  SimulationStatistics statistics;
+  REQUIRE(statistics.on_simulations_complete({.simulation_count = 2, .cumulative_reward = 1}) == 0);
+  REQUIRE(statistics.on_simulations_complete({}) == 2);
+  REQUIRE(statistics.on_simulations_complete({.simulation_count = 3, .cumulative_reward = -0.5}) == 2);
+  REQUIRE(statistics.simulation_count() == 5);
+  REQUIRE(statistics.cumulative_reward() == 0.5);
+}
 }  // namespace
 }  // namespace prodigy::mcts
@@ -1,4 +1,7 @@
+#include <algorithm>
 #include <catch2/catch_test_macros.hpp>
+#include <concepts>
+#include <type_traits>
 #include <utility>
 
 import prodigy.core;
@@ -240,9 +243,15 @@ TEST_CASE("tree") {
           [](auto&&...) { FAIL(); },
       });
     }
-    REQUIRE(quiet_moves == 30);
+    // With runtime castling rights, edges never carry them.
+    if constexpr (move_generator::RUNTIME_CASTLING_RIGHTS) {
+      REQUIRE(quiet_moves == 37);
+      REQUIRE(quiet_moves_new_castling_rights == 0);
+    } else {
+      REQUIRE(quiet_moves == 30);
+      REQUIRE(quiet_moves_new_castling_rights == 7);
+    }
     REQUIRE(enable_en_passants == 1);
-    REQUIRE(quiet_moves_new_castling_rights == 7);
     REQUIRE(captures == 8);
     REQUIRE(kingside_castles == 1);
     REQUIRE(queenside_castles == 1);
@@ -254,6 +263,7 @@ TEST_CASE("tree") {
     REQUIRE(tree.position() == position);
     REQUIRE(tree.root().edges().size() == 36);
     auto quiet_moves = 0UZ;
+    auto captures = 0UZ;
     auto captures_new_castling_rights = 0UZ;
     auto quiet_promotions = 0UZ;
     auto capture_promotions = 0UZ;
@@ -262,6 +272,7 @@ TEST_CASE("tree") {
     for (const auto& edge : tree.root().edges()) {
       edge.visit_move<Color::WHITE>(visitor{
           [&](const QuietMove&) { ++quiet_moves; },
+          [&](const Capture&) { ++captures; },
           [&](const Capture&, CastlingRights) { ++captures_new_castling_rights; },
           [&](const QuietPromotion&) { ++quiet_promotions; },
           [&](const CapturePromotion&) { ++capture_promotions; },
@@ -271,10 +282,15 @@ TEST_CASE("tree") {
       });
     }
     REQUIRE(quiet_moves == 21);
-    REQUIRE(captures_new_castling_rights == 2);
     REQUIRE(quiet_promotions == 4);
-    REQUIRE(capture_promotions == 4);
-    REQUIRE(capture_promotions_new_castling_rights == 4);
+    if constexpr (move_generator::RUNTIME_CASTLING_RIGHTS) {
+      REQUIRE(captures == 2);
+      REQUIRE(capture_promotions == 8);
+    } else {
+      REQUIRE(captures_new_castling_rights == 2);
+      REQUIRE(capture_promotions == 4);
+      REQUIRE(capture_promotions_new_castling_rights == 4);
+    }
     REQUIRE(en_passants == 1);
     REQUIRE_FALSE(tree.root().is_check());
   }
@@ -293,5 +309,23 @@ TEST_CASE("tree") {
     REQUIRE(checkmate.root().is_check());
   }
 }
+
+TEST_CASE("root edge filter") {
+  REQUIRE(move_generator::init().has_value());
+  static constexpr auto position = parse_fen(KIWIPETE).value();
+  const auto is_capture = [](const Edge& edge) {
+    return edge.visit_move<Color::WHITE>(
+        [](const auto& move, auto&&...) { return std::same_as<std::remove_cvref_t<decltype(move)>, Capture>; });
+  };
+  {
+    const Tree tree(position, {}, is_capture);
+    REQUIRE(tree.root().edges().size() == 8);
+    REQUIRE(std::ranges::all_of(tree.root().edges(), is_capture));
+  }
+  {
+    const Tree tree(position, {}, [](const Edge&) { return false; });
+    REQUIRE(tree.root().edges().size() == 48);
+  }
+}
 }  // namespace
 }  // namespace prodigy::mcts
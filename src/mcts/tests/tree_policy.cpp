@@ -66,5 +66,32 @@ TEST_CASE("UCT select") {
   }
   REQUIRE(&select() == &edges[2]);
 }
+
+TEST_CASE("UCT select pending") {
+  const UCTPolicy tree_policy(std::sqrtf(2));
+  std::array<Edge, 3> edges{
+      Edge(QuietMove{
+          .origin = to_bitboard(Square::E2),
+          .target = to_bitboard(Square::E3),
+          .piece_type = PieceType::PAWN,
+      }),
+      Edge(QuietMove{
+          .origin = to_bitboard(Square::F2),
+          .target = to_bitboard(Square::F3),
+          .piece_type = PieceType::PAWN,
+      }),
+      Edge(QuietMove{
+          .origin = to_bitboard(Square::G2),
+          .target = to_bitboard(Square::G3),
+          .piece_type = PieceType::PAWN,
+      }),
+  };
+  edges[0].on_simulation_complete(0.1);
+  // The same choices as publishing the pending statistics would give.
+  std::array<PendingStatistics, 3> pending{{{}, {.simulation_count = 1, .cumulative_reward = 0.2}, {}}};
+  REQUIRE(&tree_policy.select(2, edges, pending) == &edges[2]);
+  pending[2] = {.simulation_count = 1, .cumulative_reward = 0.05};
+  REQUIRE(&tree_policy.select(3, edges, pending) == &edges[1]);
+}
 }  // namespace
 }  // namespace prodigy::mcts
@@ -1,6 +1,15 @@
 module;
 
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ranges>
 #include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 module prodigy.mcts;
 
@@ -50,15 +59,180 @@ std::span<const Edge> Node::edges() const noexcept { return {reinterpret_cast<co
 
 bool Node::is_check() const noexcept { return is_check_; }
 
-Tree::Tree(const Position& position)
-    : position_(position),
-      root_(move_generator::dispatch(
-          position_, [&]<auto context>(const auto& node) -> decltype(auto) { return expand<context>(node, arena_); })) {
+namespace {
+std::size_t subtree_bytes(const Node& node) noexcept {
+  auto bytes = sizeof(Node) + node.edges().size_bytes();
+  for (const auto& edge : node.edges()) {
+    if (const auto child = edge.child(); child != nullptr) {
+      bytes += subtree_bytes(*child);
+    }
+  }
+  return bytes;
+}
+
+// Copies the node's edges and then the node, as expand lays them out, and then the subtrees under the edges.
+template <Color side_to_move>
+Node& copy_subtree(const Node& node, Arena& arena) noexcept {
+  for (const auto& edge : std::views::reverse(node.edges())) {
+    auto& copy = edge.visit_move<side_to_move>([&](const auto&... args) -> Edge& {
+      return arena.new_object<Edge>(args...);
+    });
+    static_cast<void>(copy.on_simulations_complete({
+        .simulation_count = edge.simulation_count(),
+        .cumulative_reward = edge.cumulative_reward(),
+    }));
+    copy.prove(edge.proof());
+  }
+  auto& copy = arena.new_object<Node>(static_cast<EdgeCount>(node.edges().size()), node.is_check());
+  for (auto&& [edge, edge_copy] : std::views::zip(node.edges(), copy.edges())) {
+    if (const auto child = edge.child(); child != nullptr) {
+      edge_copy.get_or_create_child([&] -> Node& { return copy_subtree<!side_to_move>(*child, arena); },
+                                    [](const Node&) {});
+    }
+  }
+  return copy;
+}
+
+template <Color side_to_move>
+Position play(const Position& position, const Edge& edge) noexcept {
+  auto child = position;
+  edge.visit_move<side_to_move>([&](const auto& move, const auto&... args) {
+    child.board.apply<side_to_move>(move);
+    child.castling_rights = move_generator::update_castling_rights(position.castling_rights, move);
+    if constexpr ((std::same_as<std::remove_cvref_t<decltype(args)>, Edge::EnableEnPassant> || ...)) {
+      child.en_passant_victim_origin = move.target;
+    } else {
+      child.en_passant_victim_origin = Bitboard();
+    }
+    if constexpr (std::same_as<std::remove_cvref_t<decltype(move)>, QuietMove>) {
+      child.halfmove_clock = move.piece_type == PieceType::PAWN
+                                 ? Ply{0}
+                                 : static_cast<Ply>(std::to_underlying(position.halfmove_clock) + 1);
+    } else if constexpr (std::derived_from<std::remove_cvref_t<decltype(move)>, Castle>) {
+      child.halfmove_clock = static_cast<Ply>(std::to_underlying(position.halfmove_clock) + 1);
+    } else {
+      child.halfmove_clock = Ply{0};
+    }
+  });
+  child.side_to_move = !side_to_move;
+  if constexpr (side_to_move == Color::BLACK) {
+    ++child.fullmove_number;
+  }
+  return child;
+}
+
+// Depth first, so a position found through several paths is found through the first.
+template <Color side_to_move>
+bool find(const Node& node, const Position& position, const Hash hash, const std::size_t max_depth,
+          std::vector<const Edge*>& path) {
+  for (const auto& edge : node.edges()) {
+    const auto child = edge.child();
+    if (child == nullptr) {
+      continue;
+    }
+    path.push_back(&edge);
+    const auto child_position = play<side_to_move>(position, edge);
+    if (child_position.hash() == hash ||
+        (max_depth > 1 && find<!side_to_move>(*child, child_position, hash, max_depth - 1, path))) {
+      return true;
+    }
+    path.pop_back();
+  }
+  return false;
+}
+}  // namespace
+
+Tree::Tree(const Position& position, const std::span<const Hash> history,
+           const std::function<bool(const Edge&)>& root_edge_filter)
+    : position_(position), history_(history.begin(), history.end()), root_(make_root(root_edge_filter)) {}
+
+Tree::Tree(const Position& position, const std::span<const Hash> history, const Edge& reused_edge)
+    : arena_(subtree_bytes(*reused_edge.child())),
+      position_(position),
+      history_(history.begin(), history.end()),
+      root_(copy_root(*reused_edge.child())) {
+  static_cast<void>(on_simulations_complete({
+      .simulation_count = reused_edge.simulation_count(),
+      .cumulative_reward = reused_edge.cumulative_reward(),
+  }));
+}
+
+Node& Tree::make_root(const std::function<bool(const Edge&)>& root_edge_filter) {
+  return move_generator::dispatch(position_, [&]<auto context>(const auto& node) -> Node& {
+    auto& root = expand<context>(node, arena_);
+    if (!root_edge_filter) {
+      return root;
+    }
+    // Edges sit right above their node and the arena grows down, so copying in reverse keeps their order.
+    EdgeCount edge_count = 0;
+    for (const auto& edge : std::views::reverse(root.edges())) {
+      if (root_edge_filter(edge)) {
+        edge.visit_move<context.side_to_move>([&](const auto&... args) { arena_.new_object<Edge>(args...); });
+        ++edge_count;
+      }
+    }
+    return edge_count == 0 ? root : arena_.new_object<Node>(edge_count, root.is_check());
+  });
+}
+
+Node& Tree::copy_root(const Node& reused_root) {
+  switch (position_.side_to_move) {
+    case Color::WHITE:
+      return copy_subtree<Color::WHITE>(reused_root, arena_);
+    case Color::BLACK:
+      return copy_subtree<Color::BLACK>(reused_root, arena_);
+  }
 }
 
 const Position& Tree::position() const noexcept { return position_; }
 
+std::span<const Hash> Tree::history() const noexcept { return history_; }
+
 Node& Tree::root() noexcept { return root_; }
 
 const Node& Tree::root() const noexcept { return root_; }
+
+std::vector<const Edge*> Tree::find(const Position& position, const std::size_t max_depth) const {
+  std::vector<const Edge*> path;
+  if (max_depth > 0) {
+    switch (position_.side_to_move) {
+      case Color::WHITE:
+        static_cast<void>(mcts::find<Color::WHITE>(root_, position_, position.hash(), max_depth, path));
+        break;
+      case Color::BLACK:
+        static_cast<void>(mcts::find<Color::BLACK>(root_, position_, position.hash(), max_depth, path));
+        break;
+    }
+  }
+  return path;
+}
+
+Position Tree::play(const Edge& root_edge) const noexcept {
+  switch (position_.side_to_move) {
+    case Color::WHITE:
+      return mcts::play<Color::WHITE>(position_, root_edge);
+    case Color::BLACK:
+      return mcts::play<Color::BLACK>(position_, root_edge);
+  }
+}
+
+namespace {
+// Folds a value into a digest the way boost::hash_combine does, widened to 64 bits.
+constexpr std::uint64_t combine(const std::uint64_t digest, const std::uint64_t value) noexcept {
+  return digest ^ (value + 0x9E3779B97F4A7C15 + (digest << 6) + (digest >> 2));
+}
+
+std::uint64_t signature(const Node& node, std::uint64_t digest) noexcept {
+  for (const auto& edge : node.edges()) {
+    digest = combine(digest, edge.simulation_count());
+    digest = combine(digest, std::bit_cast<std::uint32_t>(edge.cumulative_reward()));
+    if (const auto child = edge.child(); child != nullptr) {
+      digest = signature(*child, digest);
+    }
+  }
+  return digest;
+}
+}  // namespace
+
+std::uint64_t Tree::signature() const noexcept { return mcts::signature(root_, 0); }
 }  // namespace prodigy::mcts
@@ -2,10 +2,12 @@ module;
 
 #include <atomic>
 #include <concepts>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <limits>
 #include <span>
+#include <vector>
 #include <utility>
 
 export module prodigy.mcts:tree;
@@ -18,6 +20,13 @@ import :simulation_statistics;
 namespace prodigy::mcts {
 export class Node;
 
+// A game-theoretic result proven by the search, from the point of view of the side making the move.
+export enum class Proof : std::uint8_t {
+  UNKNOWN,
+  WIN,
+  LOSS,
+};
+
 export class alignas(Arena::ALIGNMENT) Edge : public SimulationStatistics {
  public:
   struct EnableEnPassant {};
@@ -71,6 +80,13 @@ export class alignas(Arena::ALIGNMENT) Edge : public SimulationStatistics {
     }
   }
 
+  // Null until the child is created. Safe to call while other threads search.
+  const Node* child() const noexcept { return child_.load(std::memory_order_acquire); }
+
+  Proof proof() const noexcept { return proof_.load(std::memory_order_relaxed); }
+
+  void prove(const Proof proof) noexcept { proof_.store(proof, std::memory_order_relaxed); }
+
   std::pair<Node&, bool> get_or_create_child(std::invocable<> auto&& create_child,
                                              std::invocable<const Node&> auto&& delete_child) {
     auto child = child_.load(std::memory_order_acquire);
@@ -108,6 +124,8 @@ export class alignas(Arena::ALIGNMENT) Edge : public SimulationStatistics {
   };
   const MoveType move_type_;
   CastlingRights child_castling_rights_;
+  // Fits in padding.
+  std::atomic<Proof> proof_ = Proof::UNKNOWN;
   std::atomic<Node*> child_ = nullptr;
 };
 static_assert(sizeof(Edge) == 48);
@@ -138,17 +156,43 @@ static_assert(sizeof(Node) == 8);
 
 export class Tree : public SimulationStatistics {
  public:
-  explicit Tree(const Position&);
+  // The history holds the hashes of the positions played before this one since the last irreversible move, oldest
+  // first, so that searches can detect repetitions. Root edges the filter rejects are left out, unless it rejects all
+  // of them.
+  explicit Tree(const Position&, std::span<const Hash> history = {},
+                const std::function<bool(const Edge&)>& root_edge_filter = {});
+
+  // Continues from the subtree under an edge of an earlier tree, whose child is the position. The subtree is copied
+  // with its statistics and proofs, so the earlier tree's nodes may be freed once this returns.
+  explicit Tree(const Position&, std::span<const Hash> history, const Edge& reused_edge);
 
   const Position& position() const noexcept;
 
+  std::span<const Hash> history() const noexcept;
+
   Node& root() noexcept;
 
   const Node& root() const noexcept;
 
+  // The edges from the root down to the position, at most max_depth of them, or none if the search never reached it.
+  std::vector<const Edge*> find(const Position&, std::size_t max_depth) const;
+
+  // The position after a root edge's move.
+  Position play(const Edge& root_edge) const noexcept;
+
+  // A digest of every edge's statistics, depth first, which differs whenever searches explored the tree differently.
+  // Only call it once searchers are done with the tree.
+  std::uint64_t signature() const noexcept;
+
  private:
-  Arena arena_{sizeof(Node) + sizeof(Edge) * std::numeric_limits<EdgeCount>::max()};
+  Node& make_root(const std::function<bool(const Edge&)>& root_edge_filter);
+
+  Node& copy_root(const Node& reused_root);
+
+  // Room for the root twice, since filtering it copies the edges it keeps.
+  Arena arena_{2 * (sizeof(Node) + sizeof(Edge) * std::numeric_limits<EdgeCount>::max())};
   Position position_;
+  std::vector<Hash> history_;
   Node& root_;
 };
 }  // namespace prodigy::mcts
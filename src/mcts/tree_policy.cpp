@@ -10,16 +10,22 @@ module prodigy.mcts;
 namespace prodigy::mcts {
 UCTPolicy::UCTPolicy(const float exploration_constant) noexcept : exploration_constant_(exploration_constant) {}
 
-Edge& UCTPolicy::select(const SimulationCount parent_visit_count, const std::span<Edge> edges) const noexcept {
+Edge& UCTPolicy::select(const SimulationCount parent_visit_count, const std::span<Edge> edges,
+                        const std::span<const PendingStatistics> pending) const noexcept {
   assert(!edges.empty());
+  assert(pending.empty() || pending.size() == edges.size());
   const auto ln_parent_visit_count = std::logf(parent_visit_count);
   Edge* choice;
-  for (auto max_ucb = std::numeric_limits<float>::lowest(); auto& edge : edges) {
-    const auto visit_count = edge.simulation_count();
+  auto max_ucb = std::numeric_limits<float>::lowest();
+  for (auto i = 0UZ; i < edges.size(); ++i) {
+    auto& edge = edges[i];
+    const auto [pending_visit_count, pending_cumulative_reward] = pending.empty() ? PendingStatistics() : pending[i];
+    const auto visit_count = edge.simulation_count() + pending_visit_count;
     if (visit_count == 0) {
       return edge;
     }
-    if (const auto ucb = upper_confidence_bound(ln_parent_visit_count, visit_count, edge.cumulative_reward());
+    if (const auto ucb = upper_confidence_bound(ln_parent_visit_count, visit_count,
+                                                edge.cumulative_reward() + pending_cumulative_reward);
         ucb > max_ucb) {
       max_ucb = ucb;
       choice = &edge;
@@ -11,15 +11,19 @@ import :tree;
 export namespace prodigy::mcts {
 template <typename T>
 concept TreePolicy =
-    requires(const T tree_policy, const SimulationCount parent_visit_count, const std::span<Edge> edges) {
-      { tree_policy.select(parent_visit_count, edges) } noexcept -> std::same_as<Edge&>;
+    requires(const T tree_policy, const SimulationCount parent_visit_count, const std::span<Edge> edges,
+             const std::span<const PendingStatistics> pending) {
+      { tree_policy.select(parent_visit_count, edges, pending) } noexcept -> std::same_as<Edge&>;
     };
 
 class UCTPolicy {
  public:
   explicit UCTPolicy(float exploration_constant) noexcept;
 
-  Edge& select(SimulationCount parent_visit_count, std::span<Edge>) const noexcept;
+  // Pending statistics, one per edge when given, count as if they had been published. The parent visit count includes
+  // its own.
+  Edge& select(SimulationCount parent_visit_count, std::span<Edge>,
+               std::span<const PendingStatistics> pending = {}) const noexcept;
 
   float upper_confidence_bound(float ln_parent_visit_count, SimulationCount visit_count,
                                float cumulative_reward) const noexcept;
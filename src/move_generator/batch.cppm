@@ -0,0 +1,345 @@
+module;
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+
+export module prodigy.move_generator:batch;
+
+import prodigy.core;
+
+import :dispatch;
+import :kogge_stone;
+import :lookup;
+import :node;
+import :sample;
+import :visitor;
+import :walk;
+
+export namespace prodigy::move_generator {
+inline constexpr auto BATCH_SIZE = 4UZ;
+}  // namespace prodigy::move_generator
+
+namespace prodigy::move_generator {
+// One board per lane, sharing the lanes and occluded fill of the Kogge-Stone slider attacks.
+static_assert(sizeof(Lanes) == BATCH_SIZE * sizeof(std::uint64_t));
+
+template <Direction direction>
+constexpr Lanes LEFT_SHIFTS =
+    Lanes{} + static_cast<std::uint64_t>(std::to_underlying(direction) > 0 ? std::to_underlying(direction) : 0);
+
+template <Direction direction>
+constexpr Lanes RIGHT_SHIFTS =
+    Lanes{} + static_cast<std::uint64_t>(std::to_underlying(direction) < 0 ? -std::to_underlying(direction) : 0);
+
+template <Direction direction>
+constexpr Lanes MASKS = Lanes{} + std::to_underlying(shift(~Bitboard(), direction));
+
+template <Direction direction>
+constexpr Lanes shift_lanes(const Lanes lanes) noexcept {
+  return shift_lanes(lanes, LEFT_SHIFTS<direction>, RIGHT_SHIFTS<direction>) & MASKS<direction>;
+}
+
+// Attacks of every slider in the generators along the direction.
+template <Direction direction>
+constexpr Lanes slide(const Lanes generators, const Lanes empty) noexcept {
+  return occluded_fill(generators, empty, LEFT_SHIFTS<direction>, RIGHT_SHIFTS<direction>, MASKS<direction>);
+}
+
+// All ones in the lanes that are not empty.
+constexpr Lanes any_lanes(const Lanes lanes) noexcept { return Lanes{} - ((lanes | (Lanes{} - lanes)) >> 63); }
+
+// SWAR popcount of each lane, since there is no vector popcount below AVX-512.
+constexpr Lanes popcount_lanes(Lanes lanes) noexcept {
+  lanes -= (lanes >> 1) & 0x5555555555555555UL;
+  lanes = (lanes & 0x3333333333333333UL) + ((lanes >> 2) & 0x3333333333333333UL);
+  lanes = (lanes + (lanes >> 4)) & 0x0F0F0F0F0F0F0F0FUL;
+  return (lanes * 0x0101010101010101UL) >> 56;
+}
+
+template <Color color>
+constexpr Lanes pawn_attack_lanes(const Lanes pawns) noexcept {
+  if constexpr (color == Color::WHITE) {
+    return shift_lanes<Direction::NORTH_WEST>(pawns) | shift_lanes<Direction::NORTH_EAST>(pawns);
+  } else {
+    return shift_lanes<Direction::SOUTH_EAST>(pawns) | shift_lanes<Direction::SOUTH_WEST>(pawns);
+  }
+}
+
+// One set per jump, so that counting targets counts moves even when knights share a target.
+constexpr std::array<Lanes, 8> knight_jump_lanes(const Lanes knights) noexcept {
+  const auto north = shift_lanes<Direction::NORTH>(knights);
+  const auto east = shift_lanes<Direction::EAST>(knights);
+  const auto south = shift_lanes<Direction::SOUTH>(knights);
+  const auto west = shift_lanes<Direction::WEST>(knights);
+  return {
+      shift_lanes<Direction::NORTH_WEST>(north), shift_lanes<Direction::NORTH_EAST>(north),
+      shift_lanes<Direction::NORTH_EAST>(east),  shift_lanes<Direction::SOUTH_EAST>(east),
+      shift_lanes<Direction::SOUTH_EAST>(south), shift_lanes<Direction::SOUTH_WEST>(south),
+      shift_lanes<Direction::SOUTH_WEST>(west),  shift_lanes<Direction::NORTH_WEST>(west),
+  };
+}
+
+constexpr Lanes knight_attack_lanes(const Lanes knights) noexcept {
+  Lanes attacks{};
+  for (const auto jump : knight_jump_lanes(knights)) {
+    attacks |= jump;
+  }
+  return attacks;
+}
+
+constexpr Lanes king_attack_lanes(const Lanes kings) noexcept {
+  return shift_lanes<Direction::NORTH>(kings) | shift_lanes<Direction::EAST>(kings) |
+         shift_lanes<Direction::SOUTH>(kings) | shift_lanes<Direction::WEST>(kings) |
+         shift_lanes<Direction::NORTH_EAST>(kings) | shift_lanes<Direction::SOUTH_EAST>(kings) |
+         shift_lanes<Direction::SOUTH_WEST>(kings) | shift_lanes<Direction::NORTH_WEST>(kings);
+}
+
+using BoardBatch = std::array<const Board*, BATCH_SIZE>;
+
+constexpr Lanes gather(const BoardBatch& boards, const auto& get) noexcept {
+  Lanes lanes{};
+  for (auto i = 0UZ; i < BATCH_SIZE; ++i) {
+    lanes[i] = std::to_underlying(get(*boards[i]));
+  }
+  return lanes;
+}
+
+// Constraints of each lane's board.
+struct ConstraintLanes {
+  Lanes kings;
+  Lanes king_danger_sets;
+  Lanes checkers;
+  Lanes dg_pin_masks;
+  Lanes hv_pin_masks;
+
+  constexpr Constraints operator[](const std::size_t i) const noexcept {
+    return {
+        .king_origin = square_of(Bitboard{kings[i]}),
+        .king_danger_set = Bitboard{king_danger_sets[i]},
+        .checkers = Bitboard{checkers[i]},
+        .dg_pin_mask = Bitboard{dg_pin_masks[i]},
+        .hv_pin_mask = Bitboard{hv_pin_masks[i]},
+    };
+  }
+};
+
+template <Color side_to_move>
+ConstraintLanes make_batch_constraints(const BoardBatch& boards) noexcept {
+  const auto kings = gather(boards, [](const Board& board) { return board[side_to_move, PieceType::KING]; });
+  const auto empty = gather(boards, [](const Board& board) { return ~board.occupancy(); });
+  const auto pawns = gather(boards, [](const Board& board) { return board[!side_to_move, PieceType::PAWN]; });
+  const auto knights = gather(boards, [](const Board& board) { return board[!side_to_move, PieceType::KNIGHT]; });
+  const auto diagonal_sliders = gather(boards, [](const Board& board) {
+    return board[!side_to_move, PieceType::BISHOP] | board[!side_to_move, PieceType::QUEEN];
+  });
+  const auto orthogonal_sliders = gather(boards, [](const Board& board) {
+    return board[!side_to_move, PieceType::ROOK] | board[!side_to_move, PieceType::QUEEN];
+  });
+  auto king_danger_sets =
+      pawn_attack_lanes<!side_to_move>(pawns) | knight_attack_lanes(knights) |
+      king_attack_lanes(gather(boards, [](const Board& board) { return board[!side_to_move, PieceType::KING]; }));
+  auto checkers = (pawn_attack_lanes<side_to_move>(kings) & pawns) | (knight_attack_lanes(kings) & knights);
+  Lanes dg_pin_masks{};
+  Lanes hv_pin_masks{};
+  const auto walk_rays = [&]<Direction... directions>(const Lanes sliders, Lanes& pin_masks) {
+    (
+        [&] {
+          king_danger_sets |= slide<directions>(sliders, empty | kings);
+          const auto ray = slide<directions>(kings, empty);
+          const auto x_ray = slide<directions>(kings, empty | ray);
+          checkers |= ray & sliders;
+          // As in make_pin_mask, the segment runs from the king to the farthest slider seen through one piece.
+          const auto far_pinned = any_lanes(x_ray & ~ray & sliders);
+          pin_masks |= (x_ray & far_pinned) | (ray & any_lanes(ray & sliders) & ~far_pinned);
+        }(),
+        ...);
+  };
+  walk_rays.template operator()<Direction::NORTH_EAST, Direction::SOUTH_EAST, Direction::SOUTH_WEST,
+                                Direction::NORTH_WEST>(diagonal_sliders, dg_pin_masks);
+  walk_rays.template operator()<Direction::NORTH, Direction::EAST, Direction::SOUTH, Direction::WEST>(
+      orthogonal_sliders, hv_pin_masks);
+  // As in make_constraints, pins don't matter in double check. The lanes are computed anyway, so they are cleared.
+  const auto single_checks = ~any_lanes(checkers & (checkers - 1));
+  return {
+      .kings = kings,
+      .king_danger_sets = king_danger_sets,
+      .checkers = checkers,
+      .dg_pin_masks = dg_pin_masks & single_checks,
+      .hv_pin_masks = hv_pin_masks & single_checks,
+  };
+}
+
+// Pawn moves but en passants, and knight and king moves but castles, as in visit_move_groups but with a popcount per
+// lane. The check masks are gathered rather than computed in the lanes, since they are a lookup per checker.
+template <Color side_to_move>
+Lanes count_leaper_moves(const BoardBatch& boards, const ConstraintLanes& constraints) noexcept {
+  using ColorTraits = ColorTraits<side_to_move>;
+  static constexpr auto FORWARD = side_to_move == Color::WHITE ? Direction::NORTH : Direction::SOUTH;
+  static constexpr auto FORWARD_EAST = side_to_move == Color::WHITE ? Direction::NORTH_EAST : Direction::SOUTH_EAST;
+  static constexpr auto FORWARD_WEST = side_to_move == Color::WHITE ? Direction::NORTH_WEST : Direction::SOUTH_WEST;
+  static constexpr auto PROMOTION_RANK = Lanes{} + std::to_underlying(ColorTraits::PROMOTION_RANK);
+  static constexpr auto EN_PASSANT_TARGET_RANK = Lanes{} + std::to_underlying(ColorTraits::EN_PASSANT_TARGET_RANK);
+  const auto own = gather(boards, [](const Board& board) { return board[side_to_move]; });
+  const auto enemy = gather(boards, [](const Board& board) { return board[!side_to_move]; });
+  const auto empty = gather(boards, [](const Board& board) { return ~board.occupancy(); });
+  const auto pawns = gather(boards, [](const Board& board) { return board[side_to_move, PieceType::PAWN]; });
+  const auto knights = gather(boards, [](const Board& board) { return board[side_to_move, PieceType::KNIGHT]; });
+  Lanes check_masks{};
+  for (auto i = 0UZ; i < BATCH_SIZE; ++i) {
+    const auto checkers = Bitboard{constraints.checkers[i]};
+    switch (popcount(checkers)) {
+      case 0:
+        check_masks[i] = std::to_underlying(~Bitboard());
+        break;
+      case 1:
+        check_masks[i] = std::to_underlying(
+            half_open_segment(square_of(checkers), square_of(Bitboard{constraints.kings[i]})));
+        break;
+      default:
+        break;
+    }
+  }
+  // Pinned pieces move along their pin, and only out of check.
+  const auto unchecked = ~any_lanes(constraints.checkers);
+  const auto dg_pin_masks = constraints.dg_pin_masks;
+  const auto hv_pin_masks = constraints.hv_pin_masks;
+  const auto unpinned = ~(dg_pin_masks | hv_pin_masks);
+  const auto count_pawn_targets = [](const Lanes targets) {
+    return popcount_lanes(targets & ~PROMOTION_RANK) +
+           popcount_lanes(targets & PROMOTION_RANK) * static_cast<std::uint64_t>(PROMOTION_COUNT);
+  };
+  const auto count_pushes = [&](const Lanes origins, const Lanes target_mask) {
+    const auto single_push_targets = shift_lanes<FORWARD>(origins) & empty;
+    const auto double_push_targets = shift_lanes<FORWARD>(single_push_targets & EN_PASSANT_TARGET_RANK) & empty;
+    return count_pawn_targets(single_push_targets & target_mask) + popcount_lanes(double_push_targets & target_mask);
+  };
+  const auto count_captures = [&](const Lanes origins, const Lanes target_mask) {
+    return count_pawn_targets(shift_lanes<FORWARD_EAST>(origins) & enemy & target_mask) +
+           count_pawn_targets(shift_lanes<FORWARD_WEST>(origins) & enemy & target_mask);
+  };
+  auto move_counts = count_pushes(pawns & unpinned, check_masks) +
+                     count_pushes(pawns & hv_pin_masks & ~dg_pin_masks, hv_pin_masks & unchecked) +
+                     count_captures(pawns & unpinned, check_masks) +
+                     count_captures(pawns & dg_pin_masks & ~hv_pin_masks, dg_pin_masks & unchecked);
+  for (const auto jump : knight_jump_lanes(knights & unpinned)) {
+    move_counts += popcount_lanes(jump & ~own & check_masks);
+  }
+  return move_counts + popcount_lanes(king_attack_lanes(constraints.kings) & ~own & ~constraints.king_danger_sets);
+}
+
+class NullVisitor : public Visitor<NullVisitor> {
+ public:
+  template <Node::Context>
+  void visit_pawn_move(const auto&) const noexcept {}
+
+  template <Node::Context>
+  void visit_knight_move(const auto&) const noexcept {}
+
+  template <Node::Context>
+  void visit_bishop_move(const auto&) const noexcept {}
+
+  template <Node::Context>
+  void visit_rook_move(const auto&) const noexcept {}
+
+  template <Node::Context>
+  void visit_queen_move(const auto&) const noexcept {}
+
+  template <Node::Context>
+  void visit_king_move(const auto&) const noexcept {}
+
+  void is_check() const noexcept {}
+};
+
+// The moves count_leaper_moves leaves out: castles, en passants and slider moves.
+template <Node::Context context>
+int count_non_leaper_moves(const Node& node, const Constraints& constraints) noexcept {
+  static constexpr auto side_to_move = context.side_to_move;
+  int move_count = 0;
+  const auto count_group = [&](const int group_move_count, const auto&) { move_count += group_move_count; };
+  NullVisitor visitor;
+  walk_castles<context>(node, constraints.king_danger_set, [&]<auto>(const auto&) { ++move_count; });
+  const auto count_non_king_moves = [&](const auto... check_mask) {
+    const auto [dg_pinned, unpinned] = make_pinned_and_unpinned<side_to_move, PieceType::PAWN>(
+        node.board, ~constraints.hv_pin_mask, constraints.dg_pin_mask);
+    visit_en_passant_group<context>(node, constraints.dg_pin_mask, dg_pinned, unpinned,
+                                    make_visit_move<context, PieceType::PAWN>(visitor), count_group, check_mask...);
+    visit_slider_move_groups<context>(node, constraints, visitor, count_group, check_mask...);
+  };
+  switch (popcount(constraints.checkers)) {
+    case 0:
+      count_non_king_moves();
+      break;
+    case 1:
+      count_non_king_moves(half_open_segment(square_of(constraints.checkers), constraints.king_origin));
+      break;
+    default:
+      break;
+  }
+  return move_count;
+}
+}  // namespace prodigy::move_generator
+
+export namespace prodigy::move_generator {
+// Same as make_constraints for each board, BATCH_SIZE boards at a time in vector lanes.
+template <Color side_to_move>
+void make_constraints(const std::span<const Board> boards, const std::span<Constraints> constraints) noexcept {
+  assert(boards.size() == constraints.size());
+  auto i = 0UZ;
+  for (; i + BATCH_SIZE <= boards.size(); i += BATCH_SIZE) {
+    BoardBatch batch;
+    for (auto j = 0UZ; j < BATCH_SIZE; ++j) {
+      batch[j] = &boards[i + j];
+    }
+    const auto constraint_lanes = make_batch_constraints<side_to_move>(batch);
+    for (auto j = 0UZ; j < BATCH_SIZE; ++j) {
+      constraints[i + j] = constraint_lanes[j];
+    }
+  }
+  for (; i < boards.size(); ++i) {
+    constraints[i] = make_constraints<side_to_move>(boards[i]);
+  }
+}
+
+// Number of legal moves, counted by popcounts without visiting any of them.
+template <Node::Context context>
+int count_moves(const Node& node, const Constraints& constraints) noexcept {
+  int move_count = 0;
+  NullVisitor visitor;
+  visit_move_groups<context>(node, constraints, visitor,
+                             [&](const int group_move_count, const auto&) { move_count += group_move_count; });
+  return move_count;
+}
+
+// Same as count_moves for each position, BATCH_SIZE positions at a time in vector lanes. Pawn, knight and king moves
+// are counted in the lanes, while slider moves, castles and en passants are counted per position.
+template <Color side_to_move>
+void count_moves(const std::span<const Position> positions, const std::span<int> move_counts) noexcept {
+  assert(positions.size() == move_counts.size());
+  auto i = 0UZ;
+  for (; i + BATCH_SIZE <= positions.size(); i += BATCH_SIZE) {
+    BoardBatch batch;
+    for (auto j = 0UZ; j < BATCH_SIZE; ++j) {
+      assert(positions[i + j].side_to_move == side_to_move);
+      batch[j] = &positions[i + j].board;
+    }
+    const auto constraint_lanes = make_batch_constraints<side_to_move>(batch);
+    const auto leaper_move_counts = count_leaper_moves<side_to_move>(batch, constraint_lanes);
+    for (auto j = 0UZ; j < BATCH_SIZE; ++j) {
+      move_counts[i + j] = static_cast<int>(leaper_move_counts[j]) +
+                           dispatch(positions[i + j], [&]<auto context>(const auto& node) {
+                             return count_non_leaper_moves<context>(node, constraint_lanes[j]);
+                           });
+    }
+  }
+  for (; i < positions.size(); ++i) {
+    assert(positions[i].side_to_move == side_to_move);
+    move_counts[i] = dispatch(positions[i], [&]<auto context>(const auto& node) {
+      return count_moves<context>(node, make_constraints<side_to_move>(node.board));
+    });
+  }
+}
+}  // namespace prodigy::move_generator
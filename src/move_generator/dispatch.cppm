@@ -22,11 +22,18 @@ constexpr decltype(auto) dispatch(const Position& position, auto&& callback) {
   const auto dispatch_can_en_passant = [&](auto&& callback) -> decltype(auto) {
     return empty(position.en_passant_victim_origin) ? HANDLE(false) : HANDLE(true);
   };
+  const auto dispatch_castling_rights = [&](auto&& callback) -> decltype(auto) {
+    if constexpr (RUNTIME_CASTLING_RIGHTS) {
+      return HANDLE(ColorTraits<Color::WHITE>::CASTLING_RIGHTS | ColorTraits<Color::BLACK>::CASTLING_RIGHTS);
+    } else {
+      return dispatch(position.castling_rights, std::forward<decltype(callback)>(callback));
+    }
+  };
   return dispatch_side_to_move([&]<auto side_to_move> -> decltype(auto) {
-    return dispatch(position.castling_rights, [&]<auto castling_rights> -> decltype(auto) {
+    return dispatch_castling_rights([&]<auto castling_rights> -> decltype(auto) {
       return dispatch_can_en_passant([&]<auto can_en_passant> -> decltype(auto) {
         return HANDLE((Node::Context{side_to_move, castling_rights, can_en_passant}),
-                      Node{position.board, position.en_passant_victim_origin});
+                      Node{position.board, position.en_passant_victim_origin, position.castling_rights});
       });
     });
   });
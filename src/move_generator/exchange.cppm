@@ -0,0 +1,99 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <utility>
+
+export module prodigy.move_generator:exchange;
+
+import prodigy.core;
+
+import :lookup;
+
+namespace prodigy::move_generator {
+constexpr Bitboard diagonal_sliders(const Board& board) noexcept {
+  return board[Color::WHITE, PieceType::BISHOP] | board[Color::BLACK, PieceType::BISHOP] |
+         board[Color::WHITE, PieceType::QUEEN] | board[Color::BLACK, PieceType::QUEEN];
+}
+
+constexpr Bitboard orthogonal_sliders(const Board& board) noexcept {
+  return board[Color::WHITE, PieceType::ROOK] | board[Color::BLACK, PieceType::ROOK] |
+         board[Color::WHITE, PieceType::QUEEN] | board[Color::BLACK, PieceType::QUEEN];
+}
+}  // namespace prodigy::move_generator
+
+export namespace prodigy::move_generator {
+inline constexpr auto EXCHANGE_VALUES = [] {
+  EnumMap<PieceType, int> exchange_values;
+  exchange_values[PieceType::PAWN] = 100;
+  exchange_values[PieceType::KNIGHT] = 300;
+  exchange_values[PieceType::BISHOP] = 300;
+  exchange_values[PieceType::ROOK] = 500;
+  exchange_values[PieceType::QUEEN] = 900;
+  exchange_values[PieceType::KING] = 20000;
+  return exchange_values;
+}();
+
+// Pieces of either color attacking the square, seeing through anything missing from the occupancy.
+inline Bitboard attackers_to(const Board& board, const Square square, const Bitboard occupancy) noexcept {
+  const auto target = to_bitboard(square);
+  return ((board[Color::WHITE, PieceType::PAWN] &
+           (pawn_left_attack_set(Color::BLACK, target) | pawn_right_attack_set(Color::BLACK, target))) |
+          (board[Color::BLACK, PieceType::PAWN] &
+           (pawn_left_attack_set(Color::WHITE, target) | pawn_right_attack_set(Color::WHITE, target))) |
+          ((board[Color::WHITE, PieceType::KNIGHT] | board[Color::BLACK, PieceType::KNIGHT]) &
+           knight_attack_set(square)) |
+          (diagonal_sliders(board) & bishop_attack_set(square, occupancy)) |
+          (orthogonal_sliders(board) & rook_attack_set(square, occupancy)) |
+          ((board[Color::WHITE, PieceType::KING] | board[Color::BLACK, PieceType::KING]) & king_attack_set(square))) &
+         occupancy;
+}
+
+// Material balance of the capture for the side making it once both sides have recaptured on the target for as long as
+// it pays off, always with their least valuable attacker. The capture must be legal, and kings only recapture once the
+// opponent has no attackers left, since they could not capture into an attacked square. Pins are ignored.
+template <Color side_to_move>
+int see(const Board& board, const Capture& move) noexcept {
+  const auto target = square_of(move.target);
+  // Every capture removes a piece other than the first victim, so there are at most 31 of them.
+  std::array<int, 32> gains{};
+  gains[0] = EXCHANGE_VALUES[move.victim];
+  auto depth = 0;
+  auto side = side_to_move;
+  auto occupancy = board.occupancy();
+  auto attackers = attackers_to(board, target, occupancy);
+  auto origin = move.origin;
+  auto aggressor = move.aggressor;
+  do {
+    ++depth;
+    // What the opponent wins if they recapture the aggressor.
+    gains[depth] = EXCHANGE_VALUES[aggressor] - gains[depth - 1];
+    if (std::max(-gains[depth - 1], gains[depth]) < 0) {
+      break;
+    }
+    occupancy ^= origin;
+    // Sliders behind the piece that just captured join in.
+    attackers = (attackers | (diagonal_sliders(board) & bishop_attack_set(target, occupancy)) |
+                 (orthogonal_sliders(board) & rook_attack_set(target, occupancy))) &
+                occupancy;
+    side = !side;
+    origin = Bitboard();
+    for (const auto piece_type : {PieceType::PAWN, PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK,
+                                  PieceType::QUEEN, PieceType::KING}) {
+      if (const auto origins = attackers & board[side, piece_type]; any(origins)) {
+        if (piece_type == PieceType::KING && any(attackers & board[!side])) {
+          break;
+        }
+        origin = origins & Bitboard{-std::to_underlying(origins)};
+        aggressor = piece_type;
+        break;
+      }
+    }
+  } while (any(origin));
+  while (--depth > 0) {
+    gains[depth - 1] = -std::max(-gains[depth - 1], gains[depth]);
+  }
+  return gains[0];
+}
+}  // namespace prodigy::move_generator
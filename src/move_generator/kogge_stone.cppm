@@ -0,0 +1,59 @@
+module;
+
+#include <cstdint>
+#include <utility>
+
+export module prodigy.move_generator:kogge_stone;
+
+import prodigy.core;
+
+namespace prodigy::move_generator {
+// Four 64-bit lanes fit one AVX2 register and are split into two SSE2 registers otherwise.
+using Lanes [[gnu::vector_size(4 * sizeof(std::uint64_t))]] = std::uint64_t;
+
+// Shifts each lane by its own direction, as a left and a right shift of which at least one is by zero bits.
+constexpr Lanes shift_lanes(const Lanes lanes, const Lanes left_shifts, const Lanes right_shifts,
+                            const std::uint64_t steps = 1) noexcept {
+  return (lanes << (left_shifts * steps)) >> (right_shifts * steps);
+}
+
+// Kogge-Stone occluded fill: attacks of the generators through the empty squares, where the masks hold the squares a
+// step can land on so that east and west steps don't wrap around the board. Lanes hold one direction each for a
+// single slider, or one board each for a batch.
+constexpr Lanes occluded_fill(Lanes generators, const Lanes empty, const Lanes left_shifts, const Lanes right_shifts,
+                              const Lanes masks) noexcept {
+  auto propagators = masks & empty;
+  generators |= propagators & shift_lanes(generators, left_shifts, right_shifts, 1);
+  propagators &= shift_lanes(propagators, left_shifts, right_shifts, 1);
+  generators |= propagators & shift_lanes(generators, left_shifts, right_shifts, 2);
+  propagators &= shift_lanes(propagators, left_shifts, right_shifts, 2);
+  generators |= propagators & shift_lanes(generators, left_shifts, right_shifts, 4);
+  return masks & shift_lanes(generators, left_shifts, right_shifts);
+}
+}  // namespace prodigy::move_generator
+
+export namespace prodigy::move_generator {
+// Table-free slider attacks, one direction per lane.
+template <Direction... DIRECTIONS>
+  requires(sizeof...(DIRECTIONS) == 4)
+class KoggeStone {
+ public:
+  static Bitboard attack_set(const Square origin, const Bitboard occupancy) noexcept {
+    const auto attack_sets = occluded_fill(Lanes{} + std::to_underlying(to_bitboard(origin)),
+                                           Lanes{} + std::to_underlying(~occupancy), LEFT_SHIFTS, RIGHT_SHIFTS, MASKS);
+    return Bitboard{attack_sets[0] | attack_sets[1] | attack_sets[2] | attack_sets[3]};
+  }
+
+ private:
+  static constexpr Lanes LEFT_SHIFTS{
+      static_cast<std::uint64_t>(std::to_underlying(DIRECTIONS) > 0 ? std::to_underlying(DIRECTIONS) : 0)...};
+  static constexpr Lanes RIGHT_SHIFTS{
+      static_cast<std::uint64_t>(std::to_underlying(DIRECTIONS) < 0 ? -std::to_underlying(DIRECTIONS) : 0)...};
+  static constexpr Lanes MASKS{std::to_underlying(shift(~Bitboard(), DIRECTIONS))...};
+};
+
+using BishopKoggeStone =
+    KoggeStone<Direction::NORTH_EAST, Direction::SOUTH_EAST, Direction::SOUTH_WEST, Direction::NORTH_WEST>;
+
+using RookKoggeStone = KoggeStone<Direction::NORTH, Direction::EAST, Direction::SOUTH, Direction::WEST>;
+}  // namespace prodigy::move_generator
@@ -6,6 +6,7 @@ module prodigy.move_generator:lookup;
 
 import prodigy.core;
 
+import :kogge_stone;
 import :magic_bitboards;
 
 namespace prodigy::move_generator {
@@ -95,11 +96,19 @@ constexpr Bitboard knight_attack_set(const Square origin) noexcept {
 }
 
 inline Bitboard bishop_attack_set(const Square origin, const Bitboard occupancy) noexcept {
+#if PRODIGY_KOGGE_STONE_SLIDERS
+  return BishopKoggeStone::attack_set(origin, occupancy);
+#else
   return BishopMagicBitboards::attack_set(origin, occupancy);
+#endif
 }
 
 inline Bitboard rook_attack_set(const Square origin, const Bitboard occupancy) noexcept {
+#if PRODIGY_KOGGE_STONE_SLIDERS
+  return RookKoggeStone::attack_set(origin, occupancy);
+#else
   return RookMagicBitboards::attack_set(origin, occupancy);
+#endif
 }
 
 constexpr Bitboard king_attack_set(const Square origin) noexcept {
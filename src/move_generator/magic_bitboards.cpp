@@ -77,8 +77,10 @@ void MagicBitboards<DIRECTIONS...>::init() noexcept {
   });
 }
 
+#if !PRODIGY_KOGGE_STONE_SLIDERS
 template class MagicBitboards<Direction::NORTH_EAST, Direction::SOUTH_EAST, Direction::SOUTH_WEST,
                               Direction::NORTH_WEST>;
 
 template class MagicBitboards<Direction::NORTH, Direction::EAST, Direction::SOUTH, Direction::WEST>;
+#endif
 }  // namespace prodigy::move_generator
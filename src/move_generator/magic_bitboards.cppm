@@ -6,11 +6,11 @@ module;
 #include <magic_enum/magic_enum_utility.hpp>
 #include <utility>
 
-module prodigy.move_generator:magic_bitboards;
+export module prodigy.move_generator:magic_bitboards;
 
 import prodigy.core;
 
-namespace prodigy::move_generator {
+export namespace prodigy::move_generator {
 template <Direction... DIRECTIONS>
 class MagicBitboards {
  public:
@@ -65,10 +65,12 @@ class MagicBitboards {
 using BishopMagicBitboards =
     MagicBitboards<Direction::NORTH_EAST, Direction::SOUTH_EAST, Direction::SOUTH_WEST, Direction::NORTH_WEST>;
 
+using RookMagicBitboards = MagicBitboards<Direction::NORTH, Direction::EAST, Direction::SOUTH, Direction::WEST>;
+}  // namespace prodigy::move_generator
+
+namespace prodigy::move_generator {
 extern template class MagicBitboards<Direction::NORTH_EAST, Direction::SOUTH_EAST, Direction::SOUTH_WEST,
                                      Direction::NORTH_WEST>;
 
-using RookMagicBitboards = MagicBitboards<Direction::NORTH, Direction::EAST, Direction::SOUTH, Direction::WEST>;
-
 extern template class MagicBitboards<Direction::NORTH, Direction::EAST, Direction::SOUTH, Direction::WEST>;
 }  // namespace prodigy::move_generator
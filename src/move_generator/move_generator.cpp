@@ -11,8 +11,10 @@ std::expected<void, std::string_view> init() noexcept {
   if (static bool initialized = false; std::exchange(initialized, true)) {
     return std::unexpected("Already initialized.");
   }
+#if !PRODIGY_KOGGE_STONE_SLIDERS
   BishopMagicBitboards::init();
   RookMagicBitboards::init();
+#endif
   return {};
 }
 }  // namespace prodigy::move_generator
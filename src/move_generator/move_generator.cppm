@@ -5,8 +5,14 @@ module;
 
 export module prodigy.move_generator;
 
+export import :batch;
 export import :dispatch;
+export import :exchange;
+export import :kogge_stone;
+export import :magic_bitboards;
+export import :move_list;
 export import :node;
+export import :sample;
 export import :visitor;
 export import :walk;
 
@@ -0,0 +1,241 @@
+module;
+
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+export module prodigy.move_generator:move_list;
+
+import prodigy.core;
+
+import :node;
+import :visitor;
+import :walk;
+
+export namespace prodigy::move_generator {
+// A legal move in a few bytes, enough to rebuild the move and its child context given the parent node and context.
+struct EncodedMove {
+  enum class Kind : std::uint8_t {
+    QUIET_MOVE,
+    DOUBLE_PUSH,
+    CAPTURE,
+    EN_PASSANT,
+    KINGSIDE_CASTLE,
+    QUEENSIDE_CASTLE,
+    QUIET_PROMOTION,
+    CAPTURE_PROMOTION,
+  };
+
+  // The king squares for castles.
+  Square origin;
+  Square target;
+  Kind kind;
+  // The moved piece, or the promotion for promotions.
+  PieceType piece_type;
+  // Only meaningful for captures and capture promotions.
+  PieceType victim;
+  CastlingRights child_castling_rights;
+
+  friend constexpr bool operator==(EncodedMove, EncodedMove) = default;
+};
+
+// No legal chess position has more moves than this.
+inline constexpr auto MAX_MOVE_COUNT = 218UZ;
+
+// Fixed-capacity list of the legal moves of a node, in walk order.
+class MoveList {
+ public:
+  constexpr auto begin() noexcept { return moves_.begin(); }
+  constexpr auto begin() const noexcept { return moves_.begin(); }
+
+  constexpr auto end() noexcept { return moves_.begin() + size_; }
+  constexpr auto end() const noexcept { return moves_.begin() + size_; }
+
+  constexpr std::size_t size() const noexcept { return size_; }
+
+  constexpr bool empty() const noexcept { return size_ == 0; }
+
+  constexpr EncodedMove& operator[](const std::size_t index) noexcept {
+    assert(index < size_);
+    return moves_[index];
+  }
+
+  constexpr const EncodedMove& operator[](const std::size_t index) const noexcept {
+    assert(index < size_);
+    return moves_[index];
+  }
+
+  constexpr void push_back(const EncodedMove& move) noexcept {
+    assert(size_ < MAX_MOVE_COUNT);
+    moves_[size_++] = move;
+  }
+
+ private:
+  std::array<EncodedMove, MAX_MOVE_COUNT> moves_;
+  std::size_t size_ = 0;
+};
+}  // namespace prodigy::move_generator
+
+namespace prodigy::move_generator {
+class MoveListVisitor : public Visitor<MoveListVisitor> {
+ public:
+  constexpr explicit MoveListVisitor(MoveList& moves) noexcept : moves_(moves) {}
+
+  template <Node::Context child_context>
+  constexpr void visit_pawn_move(const auto& move) const noexcept {
+    push_back<child_context>(move);
+  }
+
+  template <Node::Context child_context>
+  constexpr void visit_knight_move(const auto& move) const noexcept {
+    push_back<child_context>(move);
+  }
+
+  template <Node::Context child_context>
+  constexpr void visit_bishop_move(const auto& move) const noexcept {
+    push_back<child_context>(move);
+  }
+
+  template <Node::Context child_context>
+  constexpr void visit_rook_move(const auto& move) const noexcept {
+    push_back<child_context>(move);
+  }
+
+  template <Node::Context child_context>
+  constexpr void visit_queen_move(const auto& move) const noexcept {
+    push_back<child_context>(move);
+  }
+
+  template <Node::Context child_context>
+  constexpr void visit_king_move(const auto& move) const noexcept {
+    push_back<child_context>(move);
+  }
+
+  constexpr void is_check() const noexcept {}
+
+ private:
+  template <Node::Context child_context>
+  constexpr void push_back(const auto& move) const noexcept {
+    using Move = std::remove_cvref_t<decltype(move)>;
+    using enum EncodedMove::Kind;
+    const auto encode = [](const Bitboard origin, const Bitboard target, const EncodedMove::Kind kind,
+                           const PieceType piece_type, const PieceType victim = PieceType{}) {
+      return EncodedMove{
+          .origin = square_of(origin),
+          .target = square_of(target),
+          .kind = kind,
+          .piece_type = piece_type,
+          .victim = victim,
+          .child_castling_rights = child_context.castling_rights,
+      };
+    };
+    if constexpr (std::same_as<Move, QuietMove>) {
+      moves_.push_back(encode(move.origin, move.target, child_context.can_en_passant ? DOUBLE_PUSH : QUIET_MOVE,
+                              move.piece_type));
+    } else if constexpr (std::same_as<Move, Capture>) {
+      moves_.push_back(encode(move.origin, move.target, CAPTURE, move.aggressor, move.victim));
+    } else if constexpr (std::same_as<Move, EnPassant>) {
+      moves_.push_back(encode(move.origin, move.target, EN_PASSANT, PieceType::PAWN));
+    } else if constexpr (std::same_as<Move, KingsideCastle>) {
+      moves_.push_back(encode(move.king_origin, move.king_target, KINGSIDE_CASTLE, PieceType::KING));
+    } else if constexpr (std::same_as<Move, QueensideCastle>) {
+      moves_.push_back(encode(move.king_origin, move.king_target, QUEENSIDE_CASTLE, PieceType::KING));
+    } else if constexpr (std::same_as<Move, QuietPromotion>) {
+      moves_.push_back(encode(move.origin, move.target, QUIET_PROMOTION, move.promotion));
+    } else {
+      static_assert(std::same_as<Move, CapturePromotion>);
+      moves_.push_back(encode(move.origin, move.target, CAPTURE_PROMOTION, move.promotion, move.victim));
+    }
+  }
+
+  MoveList& moves_;
+};
+}  // namespace prodigy::move_generator
+
+export namespace prodigy::move_generator {
+template <Node::Context context>
+constexpr MoveList make_move_list(const Node& node) noexcept {
+  MoveList moves;
+  walk<context>(node, MoveListVisitor(moves));
+  return moves;
+}
+
+// Calls the callback with the move the encoding stands for in a node of the context.
+template <Node::Context context>
+constexpr decltype(auto) decode(const Node& node, const EncodedMove move, auto&& callback) {
+  const auto origin = to_bitboard(move.origin);
+  const auto target = to_bitboard(move.target);
+  using enum EncodedMove::Kind;
+  switch (move.kind) {
+    case QUIET_MOVE:
+    case DOUBLE_PUSH:
+      return std::forward<decltype(callback)>(callback)(QuietMove{
+          .origin = origin,
+          .target = target,
+          .piece_type = move.piece_type,
+      });
+    case CAPTURE:
+      return std::forward<decltype(callback)>(callback)(Capture{
+          .origin = origin,
+          .target = target,
+          .aggressor = move.piece_type,
+          .victim = move.victim,
+      });
+    case EN_PASSANT:
+      return std::forward<decltype(callback)>(callback)(EnPassant{
+          .origin = origin,
+          .target = target,
+          .victim_origin = node.en_passant_victim_origin,
+      });
+    case KINGSIDE_CASTLE:
+      return std::forward<decltype(callback)>(callback)(ColorTraits<context.side_to_move>::KINGSIDE_CASTLE);
+    case QUEENSIDE_CASTLE:
+      return std::forward<decltype(callback)>(callback)(ColorTraits<context.side_to_move>::QUEENSIDE_CASTLE);
+    case QUIET_PROMOTION:
+      return std::forward<decltype(callback)>(callback)(QuietPromotion{
+          .origin = origin,
+          .target = target,
+          .promotion = move.piece_type,
+      });
+    case CAPTURE_PROMOTION:
+      return std::forward<decltype(callback)>(callback)(CapturePromotion{
+          .origin = origin,
+          .target = target,
+          .promotion = move.piece_type,
+          .victim = move.victim,
+      });
+  }
+  std::unreachable();
+}
+
+// Calls the callback with the child context and child node the encoded move leads to. Unlike scoped_move, the child
+// is a copy, so the node is left untouched.
+template <Node::Context context>
+constexpr decltype(auto) apply(const Node& node, const EncodedMove move, auto&& callback) {
+  auto child = node;
+  decode<context>(node, move, [&](const auto& decoded) {
+    child.board.apply<context.side_to_move>(decoded);
+    if constexpr (RUNTIME_CASTLING_RIGHTS) {
+      child.castling_rights = update_castling_rights(node.castling_rights, decoded);
+    }
+  });
+#define HANDLE(value) std::forward<decltype(callback)>(callback).template operator()<value>(std::as_const(child))
+  if (move.kind == EncodedMove::Kind::DOUBLE_PUSH) {
+    child.en_passant_victim_origin = to_bitboard(move.target);
+    return HANDLE(context.enable_en_passant());
+  }
+  if constexpr (RUNTIME_CASTLING_RIGHTS) {
+    return HANDLE(context.move(context.castling_rights));
+  } else {
+    return dispatch(move.child_castling_rights, [&]<auto child_castling_rights> -> decltype(auto) {
+      // Moves only ever take castling rights away, so masking just avoids instantiating unreachable contexts.
+      return HANDLE(context.move(child_castling_rights & context.castling_rights));
+    });
+  }
+#undef HANDLE
+}
+}  // namespace prodigy::move_generator
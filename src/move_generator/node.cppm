@@ -1,8 +1,17 @@
+module;
+
+#include <concepts>
+#include <type_traits>
+
 export module prodigy.move_generator:node;
 
 import prodigy.core;
 
 export namespace prodigy::move_generator {
+// Whether castling rights are kept in Node at runtime instead of in Node::Context. Contexts then always claim every
+// castling right, which cuts the number of instantiations of the generator and its visitors by up to 16 times.
+inline constexpr bool RUNTIME_CASTLING_RIGHTS = PRODIGY_RUNTIME_CASTLING_RIGHTS;
+
 struct Node {
   struct Context {
     Color side_to_move;
@@ -20,7 +29,7 @@ struct Node {
     consteval Context move(const CastlingRights child_castling_rights) const noexcept {
       return {
           .side_to_move = !side_to_move,
-          .castling_rights = child_castling_rights,
+          .castling_rights = RUNTIME_CASTLING_RIGHTS ? castling_rights : child_castling_rights,
           .can_en_passant = false,
       };
     }
@@ -30,7 +39,51 @@ struct Node {
 
   Board board;
   Bitboard en_passant_victim_origin;
+  // Only kept up to date with RUNTIME_CASTLING_RIGHTS.
+  CastlingRights castling_rights;
 
   friend consteval bool operator==(const Node&, const Node&) = default;
 };
+
+template <Node::Context context>
+constexpr CastlingRights castling_rights_of(const Node& node) noexcept {
+  if constexpr (RUNTIME_CASTLING_RIGHTS) {
+    return node.castling_rights;
+  } else {
+    return context.castling_rights;
+  }
+}
+
+// Clears the rights whose king or rook the move leaves or captures on its original square.
+constexpr CastlingRights update_castling_rights(CastlingRights castling_rights, const auto& move) noexcept {
+  const auto squares = [&] {
+    if constexpr (std::derived_from<std::remove_cvref_t<decltype(move)>, Castle>) {
+      return move.king_origin;
+    } else {
+      return move.origin | move.target;
+    }
+  }();
+  const auto update = [&](const Castle& castle, const CastlingRights castle_castling_rights) {
+    if (any(squares & (castle.king_origin | castle.rook_origin))) {
+      castling_rights &= ~castle_castling_rights;
+    }
+  };
+  update(ColorTraits<Color::WHITE>::KINGSIDE_CASTLE, ColorTraits<Color::WHITE>::KINGSIDE_CASTLING_RIGHTS);
+  update(ColorTraits<Color::WHITE>::QUEENSIDE_CASTLE, ColorTraits<Color::WHITE>::QUEENSIDE_CASTLING_RIGHTS);
+  update(ColorTraits<Color::BLACK>::KINGSIDE_CASTLE, ColorTraits<Color::BLACK>::KINGSIDE_CASTLING_RIGHTS);
+  update(ColorTraits<Color::BLACK>::QUEENSIDE_CASTLE, ColorTraits<Color::BLACK>::QUEENSIDE_CASTLING_RIGHTS);
+  return castling_rights;
+}
+
+// The en passant victim origin is only meaningful when the context allows en passant.
+template <Node::Context context>
+constexpr Hash hash(const Node& node) noexcept {
+  const auto hash = node.board.hash() ^ side_to_move_hash(context.side_to_move) ^
+                    castling_rights_hash(castling_rights_of<context>(node));
+  if constexpr (context.can_en_passant) {
+    return hash ^ en_passant_hash(node.en_passant_victim_origin);
+  } else {
+    return hash;
+  }
+}
 }  // namespace prodigy::move_generator
@@ -0,0 +1,99 @@
+#include <nanobench.h>
+
+#include <CLI/CLI.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <expected>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+import prodigy.core;
+import prodigy.move_generator.perft;
+import prodigy.move_generator;
+import prodigy.uci;
+
+int main(int argc, char** argv) {
+  using namespace prodigy;
+  using namespace prodigy::move_generator;
+  CLI::App app("Runs perft over EPD suites and reports move generator throughput.");
+  std::vector<std::string> epd_paths;
+  app.add_option("epd", epd_paths, "EPD files whose operations are \"D<depth> <leaf node count>\"")
+      ->required()
+      ->check(CLI::ExistingFile);
+  auto max_depth = std::numeric_limits<std::underlying_type_t<Ply>>::max();
+  app.add_option("-d,--max-depth", max_depth, "Skip depths greater than this")->check(CLI::PositiveNumber);
+  std::size_t epochs = 1;
+  app.add_option("-e,--epochs", epochs, "Timed runs per position and depth")->check(CLI::PositiveNumber);
+  bool move_list = false;
+  app.add_flag("--move-list", move_list, "Materialize a move list per node instead of visiting moves");
+  bool divide = false;
+  app.add_flag("--divide", divide, "Print the leaf node count of each root move on mismatch");
+  std::string json_path;
+  app.add_option("--json", json_path, "Write the nanobench results to this file as JSON");
+  CLI11_PARSE(app, argc, argv);
+  try {
+    init().value();
+    ankerl::nanobench::Bench bench;
+    bench.title(move_list ? "perft (move list)" : "perft").unit("node").warmup(0).epochs(epochs).epochIterations(1);
+    auto mismatches = 0UZ;
+    for (const auto& epd_path : epd_paths) {
+      std::ifstream epd_file(epd_path);
+      std::string line;
+      for (auto line_number = 1UZ; std::getline(epd_file, line); ++line_number) {
+        if (line.empty() || line.starts_with('#')) {
+          continue;
+        }
+        const auto epd = perft::parse_epd(line);
+        if (!epd.has_value()) {
+          std::clog << std::format("{}:{}: {}\n", epd_path, line_number, epd.error());
+          return EXIT_FAILURE;
+        }
+        for (const auto& [depth, expected_leaf_node_count] : epd->leaf_node_counts) {
+          if (std::to_underlying(depth) > max_depth) {
+            break;
+          }
+          std::uint64_t leaf_node_count = 0;
+          bench.batch(expected_leaf_node_count)
+              .run(std::format("{}:{} depth {}", epd_path, line_number, std::to_underlying(depth)),
+                   [&] {
+                     leaf_node_count = move_list ? perft::perft_move_list(epd->position, depth).value()
+                                                 : perft::perft(epd->position, depth).value();
+                   });
+          if (leaf_node_count == expected_leaf_node_count) {
+            continue;
+          }
+          ++mismatches;
+          std::clog << std::format("{}:{}: depth {}: expected {} leaf nodes, got {}\n", epd_path, line_number,
+                                   std::to_underlying(depth), expected_leaf_node_count, leaf_node_count);
+          if (divide) {
+            for (const auto& [move, move_leaf_node_count] : perft::divide(epd->position, depth).value()) {
+              std::clog << move << ": " << move_leaf_node_count << '\n';
+            }
+          }
+        }
+      }
+    }
+    if (!json_path.empty()) {
+      std::ofstream json(json_path);
+      ankerl::nanobench::render(ankerl::nanobench::templates::json(), bench, json);
+    }
+    if (mismatches != 0) {
+      std::clog << std::format("{} mismatches\n", mismatches);
+      return EXIT_FAILURE;
+    }
+  } catch (const std::bad_expected_access<std::string_view>& exception) {
+    std::clog << exception.error() << '\n';
+    return EXIT_FAILURE;
+  } catch (const std::exception& exception) {
+    std::clog << exception.what() << '\n';
+    return EXIT_FAILURE;
+  }
+}
@@ -1,9 +1,15 @@
 module;
 
+#include <algorithm>
+#include <charconv>
 #include <cstdint>
 #include <expected>
 #include <map>
+#include <ranges>
+#include <string>
 #include <string_view>
+#include <system_error>
+#include <type_traits>
 #include <utility>
 
 module prodigy.move_generator.perft;
@@ -94,6 +100,21 @@ class Divide : public Visitor<Divide, Perft> {
   std::map<uci::Move, std::uint64_t>& move_to_leaf_node_count_;
 };
 
+template <Node::Context context>
+std::uint64_t perft_move_list(const Node& node, const Ply depth) noexcept {
+  const auto moves = make_move_list<context>(node);
+  if (depth == Ply{1}) {
+    return moves.size();
+  }
+  std::uint64_t leaf_node_count = 0;
+  for (const auto move : moves) {
+    leaf_node_count += apply<context>(node, move, [&]<auto child_context>(const Node& child) {
+      return perft_move_list<child_context>(child, decrement(depth));
+    });
+  }
+  return leaf_node_count;
+}
+
 template <typename Visitor, typename T>
 [[nodiscard]] std::expected<T, std::string_view> perft(const Position& position, const Ply depth) noexcept {
   if (depth == Ply{0}) {
@@ -107,10 +128,65 @@ template <typename Visitor, typename T>
 }
 }  // namespace
 
+std::expected<EPD, std::string_view> parse_epd(const std::string_view epd) noexcept {
+  static constexpr auto WHITESPACE = " \f\r\t\v";
+  const auto trim = [](const std::string_view field) {
+    const auto begin = field.find_first_not_of(WHITESPACE);
+    if (begin == std::string_view::npos) {
+      return std::string_view();
+    }
+    return field.substr(begin, field.find_last_not_of(WHITESPACE) + 1 - begin);
+  };
+  const auto from_chars = [](const std::string_view field, auto& value) {
+    return std::from_chars(field.begin(), field.end(), value) == std::from_chars_result{field.end(), std::errc()};
+  };
+  const auto fen_end = std::min(epd.find(';'), epd.size());
+  const auto fen = trim(epd.substr(0, fen_end));
+  // EPD omits the halfmove clock and fullmove number, but some suites keep them.
+  const auto position = std::ranges::count(fen, ' ') == 3 ? parse_fen(std::string(fen) + " 0 1") : parse_fen(fen);
+  if (!position.has_value()) {
+    return std::unexpected(position.error());
+  }
+  EPD parsed{.position = *position};
+  for (const auto operation : epd.substr(fen_end) | std::views::split(';') | std::views::transform([&](auto&& range) {
+                                return trim(std::string_view(std::forward<decltype(range)>(range)));
+                              })) {
+    if (operation.empty()) {
+      continue;
+    }
+    const auto separator = operation.find(' ');
+    if (!operation.starts_with('D') || separator == std::string_view::npos) {
+      return std::unexpected("Invalid operation.");
+    }
+    std::underlying_type_t<Ply> depth;
+    if (!from_chars(operation.substr(1, separator - 1), depth) || depth == 0) {
+      return std::unexpected("Invalid depth.");
+    }
+    std::uint64_t leaf_node_count;
+    if (!from_chars(trim(operation.substr(separator)), leaf_node_count)) {
+      return std::unexpected("Invalid leaf node count.");
+    }
+    if (!parsed.leaf_node_counts.try_emplace(Ply{depth}, leaf_node_count).second) {
+      return std::unexpected("Duplicate depth.");
+    }
+  }
+  if (parsed.leaf_node_counts.empty()) {
+    return std::unexpected("No leaf node counts.");
+  }
+  return parsed;
+}
+
 std::expected<std::uint64_t, std::string_view> perft(const Position& position, const Ply depth) noexcept {
   return perft<Perft, std::uint64_t>(position, depth);
 }
 
+std::expected<std::uint64_t, std::string_view> perft_move_list(const Position& position, const Ply depth) noexcept {
+  if (depth == Ply{0}) {
+    return std::unexpected("Invalid depth.");
+  }
+  return dispatch(position, [&]<auto context>(const Node& node) { return perft_move_list<context>(node, depth); });
+}
+
 std::expected<std::map<uci::Move, std::uint64_t>, std::string_view> divide(const Position& position,
                                                                            const Ply depth) noexcept {
   return perft<Divide, std::map<uci::Move, std::uint64_t>>(position, depth);
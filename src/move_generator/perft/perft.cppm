@@ -11,7 +11,19 @@ import prodigy.core;
 import prodigy.uci;
 
 export namespace prodigy::move_generator::perft {
+struct EPD {
+  Position position;
+  std::map<Ply, std::uint64_t> leaf_node_counts;
+
+  friend bool operator==(const EPD&, const EPD&) = default;
+};
+
+[[nodiscard]] std::expected<EPD, std::string_view> parse_epd(std::string_view) noexcept;
+
 [[nodiscard]] std::expected<std::uint64_t, std::string_view> perft(const Position&, Ply) noexcept;
 
+// Same as perft, but materializes a MoveList per node and applies its moves instead of visiting them.
+[[nodiscard]] std::expected<std::uint64_t, std::string_view> perft_move_list(const Position&, Ply) noexcept;
+
 [[nodiscard]] std::expected<std::map<uci::Move, std::uint64_t>, std::string_view> divide(const Position&, Ply) noexcept;
 }  // namespace prodigy::move_generator::perft
@@ -53,6 +53,19 @@ TEST_CASE("perft") {
   REQUIRE(perft(parse_fen(fen).value(), depth).value() == leaf_node_count);
 }
 
+TEST_CASE("perft_move_list") {
+  const auto [fen, depth, leaf_node_count] = GENERATE(table<std::string_view, Ply, std::uint64_t>({
+      {STARTING_FEN, Ply{5}, 4'865'609},
+      {KIWIPETE, Ply{4}, 4'085'603},
+      {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", Ply{5}, 674'624},
+      {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", Ply{4}, 422'333},
+  }));
+  static_cast<void>(init());
+  INFO(fen);
+  INFO("depth " << std::to_underlying(depth));
+  REQUIRE(perft_move_list(parse_fen(fen).value(), depth).value() == leaf_node_count);
+}
+
 TEST_CASE("divide") {
   static_cast<void>(init());
   REQUIRE(divide(STARTING_POSITION, Ply{4}).value() == std::map<uci::Move, std::uint64_t>{
@@ -79,10 +92,50 @@ TEST_CASE("divide") {
                                                        });
 }
 
+TEST_CASE("parse_epd") {
+  const auto [epd, fen, leaf_node_counts] =
+      GENERATE(table<std::string_view, std::string_view, std::map<Ply, std::uint64_t>>({
+          {
+              "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - ;D1 20 ;D2 400 ;D3 8902",
+              STARTING_FEN,
+              {{Ply{1}, 20}, {Ply{2}, 400}, {Ply{3}, 8'902}},
+          },
+          {
+              "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1;D2 2039;D1 48\r",
+              KIWIPETE,
+              {{Ply{1}, 48}, {Ply{2}, 2'039}},
+          },
+      }));
+  INFO(epd);
+  REQUIRE(parse_epd(epd).value() == EPD{
+                                        .position = parse_fen(fen).value(),
+                                        .leaf_node_counts = leaf_node_counts,
+                                    });
+}
+
+TEST_CASE("invalid EPD") {
+  const auto [epd, error] = GENERATE(table<std::string_view, std::string_view>({
+      {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq", "Too few fields."},
+      {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -", "No leaf node counts."},
+      {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - ;;", "No leaf node counts."},
+      {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - ;D1", "Invalid operation."},
+      {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - ;d1 20", "Invalid operation."},
+      {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - ;D0 1", "Invalid depth."},
+      {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - ;D 20", "Invalid depth."},
+      {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - ;D1 -20", "Invalid leaf node count."},
+      {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - ;D1 20 ;D1 20", "Duplicate depth."},
+  }));
+  INFO(epd);
+  const auto result = parse_epd(epd);
+  REQUIRE_FALSE(result.has_value());
+  REQUIRE(result.error() == error);
+}
+
 TEST_CASE("invalid") {
   const auto result = perft(STARTING_POSITION, Ply{0});
   REQUIRE_FALSE(result.has_value());
   REQUIRE(result.error() == "Invalid depth.");
+  REQUIRE(perft_move_list(STARTING_POSITION, Ply{0}) == result);
 }
 }  // namespace
 }  // namespace prodigy::move_generator::perft
@@ -0,0 +1,295 @@
+module;
+
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <random>
+#include <span>
+#include <type_traits>
+
+export module prodigy.move_generator:sample;
+
+import prodigy.core;
+
+import :lookup;
+import :node;
+import :visitor;
+import :walk;
+
+namespace prodigy::move_generator {
+inline constexpr std::array PROMOTIONS{PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK, PieceType::QUEEN};
+inline constexpr auto PROMOTION_COUNT = static_cast<int>(PROMOTIONS.size());
+
+// Reports legal moves in groups as (move count, decode) where decode visits the move at the given index of the group.
+// Groups are target sets, so counting them is a popcount and only the sampled move is ever materialized. Decodes copy
+// what they need, so they may be kept and called after the walk over the groups.
+template <Color side_to_move, CastlingRights castling_rights, PieceType piece_type>
+void visit_piece_move_groups(const Board& board, const Bitboard origin_mask, const Bitboard pin_mask,
+                             const std::invocable<Square> auto& lookup_attack_set, const auto& visit_move,
+                             const auto& visit_group, const std::same_as<Bitboard> auto... check_mask) {
+  const auto visit_groups = [&](const auto origins, const auto... target_mask) {
+    for_each_bit_and_square(origins, [&](const auto origin_bit, const auto origin_square) {
+      const auto targets = ((lookup_attack_set(origin_square) & ~board[side_to_move]) & ... & target_mask);
+      visit_group(popcount(targets), [&board, origin_bit, targets, visit_move](const auto index) {
+        walk_non_pawn_quiet_moves_and_captures<side_to_move, castling_rights, piece_type, Stage::ALL>(
+            board, origin_bit, nth_bit(targets, index), visit_move);
+      });
+    });
+  };
+  const auto [pinned, unpinned] = make_pinned_and_unpinned<side_to_move, piece_type>(board, origin_mask, pin_mask);
+  visit_groups(unpinned, check_mask...);
+  if constexpr (piece_type != PieceType::KNIGHT && sizeof...(check_mask) == 0) {
+    visit_groups(pinned, pin_mask);
+  }
+}
+
+template <Node::Context context>
+void visit_en_passant_group(const Node& node, const Bitboard dg_pin_mask, const Bitboard dg_pinned,
+                            const Bitboard unpinned, const auto& visit_move, const auto& visit_group,
+                            const std::same_as<Bitboard> auto... check_mask) {
+  if constexpr (context.can_en_passant) {
+    // At most two moves, so walking them is as cheap as counting them.
+    int en_passant_count = 0;
+    walk_en_passants<context.side_to_move>(
+        node, dg_pin_mask, dg_pinned, unpinned, [&](const auto&) { ++en_passant_count; }, check_mask...);
+    visit_group(en_passant_count, [&node, dg_pin_mask, dg_pinned, unpinned, visit_move, check_mask...](auto index) {
+      walk_en_passants<context.side_to_move>(
+          node, dg_pin_mask, dg_pinned, unpinned,
+          [&](const auto& move) {
+            if (index-- == 0) {
+              visit_move.template operator()<context.castling_rights>(move);
+            }
+          },
+          check_mask...);
+    });
+  }
+}
+
+template <Node::Context context>
+void visit_pawn_move_groups(const Node& node, const Bitboard dg_pin_mask, const Bitboard hv_pin_mask,
+                            const auto& visit_move, const std::invocable<const QuietMove&> auto& visit_double_push,
+                            const auto& visit_group, const std::same_as<Bitboard> auto... check_mask) {
+  static constexpr auto side_to_move = context.side_to_move;
+  using ColorTraits = ColorTraits<side_to_move>;
+  const auto visit_push_groups = [&, empty = ~node.board.occupancy()](const auto origins, const auto... target_mask) {
+    const auto unmasked_single_push_targets = pawn_single_push_set(side_to_move, origins) & empty;
+    const auto single_push_targets = (unmasked_single_push_targets & ... & target_mask);
+    const auto promotion_targets = single_push_targets & ColorTraits::PROMOTION_RANK;
+    const auto push_targets = single_push_targets ^ promotion_targets;
+    visit_group(popcount(push_targets), [push_targets, visit_move](const auto index) {
+      const auto target = nth_bit(push_targets, index);
+      visit_move.template operator()<context.castling_rights>(QuietMove{
+          .origin = pawn_single_push_origin(side_to_move, target),
+          .target = target,
+          .piece_type = PieceType::PAWN,
+      });
+    });
+    visit_group(popcount(promotion_targets) * PROMOTION_COUNT, [promotion_targets, visit_move](const auto index) {
+      const auto target = nth_bit(promotion_targets, index / PROMOTION_COUNT);
+      visit_move.template operator()<context.castling_rights>(QuietPromotion{
+          .origin = pawn_single_push_origin(side_to_move, target),
+          .target = target,
+          .promotion = PROMOTIONS[index % PROMOTION_COUNT],
+      });
+    });
+    const auto double_push_targets =
+        pawn_single_push_set(side_to_move, unmasked_single_push_targets & ColorTraits::EN_PASSANT_TARGET_RANK) &
+        (empty & ... & target_mask);
+    visit_group(popcount(double_push_targets), [double_push_targets, visit_double_push](const auto index) {
+      const auto target = nth_bit(double_push_targets, index);
+      visit_double_push(QuietMove{
+          .origin = pawn_single_push_origin(side_to_move, pawn_single_push_origin(side_to_move, target)),
+          .target = target,
+          .piece_type = PieceType::PAWN,
+      });
+    });
+  };
+  const auto visit_single_direction_capture_groups = [&](const auto origins, const auto& lookup_attack_set,
+                                                         const auto& origin_of, const auto... target_mask) {
+    const auto targets =
+        lookup_attack_set(side_to_move, origins) & (node.board[!side_to_move] & ... & target_mask);
+    const auto promotion_targets = targets & ColorTraits::PROMOTION_RANK;
+    const auto capture_targets = targets ^ promotion_targets;
+    visit_group(popcount(capture_targets), [&node, capture_targets, origin_of, visit_move](const auto index) {
+      for_each_capture<side_to_move>(node.board, nth_bit(capture_targets, index),
+                                     [&](const auto target, const auto victim) {
+                                       visit_move.template operator()<context.castling_rights>(Capture{
+                                           .origin = origin_of(side_to_move, target),
+                                           .target = target,
+                                           .aggressor = PieceType::PAWN,
+                                           .victim = victim,
+                                       });
+                                     });
+    });
+    visit_group(popcount(promotion_targets) * PROMOTION_COUNT,
+                [&node, promotion_targets, origin_of, visit_move](const auto index) {
+                  for_each_capture<side_to_move, context.castling_rights>(
+                      node.board, nth_bit(promotion_targets, index / PROMOTION_COUNT),
+                      [&]<auto new_castling_rights>(const auto target, const auto victim) {
+                        visit_move.template operator()<new_castling_rights>(CapturePromotion{
+                            .origin = origin_of(side_to_move, target),
+                            .target = target,
+                            .promotion = PROMOTIONS[index % PROMOTION_COUNT],
+                            .victim = victim,
+                        });
+                      });
+                });
+  };
+  const auto visit_capture_groups = [&](const auto origins, const auto... target_mask) {
+    visit_single_direction_capture_groups(origins, pawn_left_attack_set, pawn_left_capture_origin, target_mask...);
+    visit_single_direction_capture_groups(origins, pawn_right_attack_set, pawn_right_capture_origin, target_mask...);
+  };
+  const auto [hv_pinned, unpinned] =
+      make_pinned_and_unpinned<side_to_move, PieceType::PAWN>(node.board, ~dg_pin_mask, hv_pin_mask);
+  visit_push_groups(unpinned, check_mask...);
+  if constexpr (sizeof...(check_mask) == 0) {
+    visit_push_groups(hv_pinned, hv_pin_mask);
+  }
+  const auto dg_pinned =
+      make_pinned_and_unpinned<side_to_move, PieceType::PAWN>(node.board, ~hv_pin_mask, dg_pin_mask).first;
+  visit_capture_groups(unpinned, check_mask...);
+  if constexpr (sizeof...(check_mask) == 0) {
+    visit_capture_groups(dg_pinned, dg_pin_mask);
+  }
+  visit_en_passant_group<context>(node, dg_pin_mask, dg_pinned, unpinned, visit_move, visit_group, check_mask...);
+}
+
+template <Node::Context context, typename T>
+void visit_slider_move_groups(const Node& node, const Constraints& constraints, Visitor<T>& visitor,
+                              const auto& visit_group, const std::same_as<Bitboard> auto... check_mask) {
+  const auto dg_pin_mask = constraints.dg_pin_mask;
+  const auto hv_pin_mask = constraints.hv_pin_mask;
+  visit_piece_move_groups<context.side_to_move, context.castling_rights, PieceType::BISHOP>(
+      node.board, ~hv_pin_mask, dg_pin_mask,
+      [&](const auto origin) { return bishop_attack_set(origin, node.board.occupancy()); },
+      make_visit_move<context, PieceType::BISHOP>(visitor), visit_group, check_mask...);
+  visit_piece_move_groups<context.side_to_move, context.castling_rights, PieceType::ROOK>(
+      node.board, ~dg_pin_mask, hv_pin_mask,
+      [&](const auto origin) { return rook_attack_set(origin, node.board.occupancy()); },
+      make_visit_move<context, PieceType::ROOK>(visitor), visit_group, check_mask...);
+  const auto visit_queen_move_groups = [&](const auto origin_mask, const auto pin_mask,
+                                           const auto& lookup_attack_set) {
+    visit_piece_move_groups<context.side_to_move, context.castling_rights, PieceType::QUEEN>(
+        node.board, origin_mask, pin_mask,
+        [&](const auto origin) { return lookup_attack_set(origin, node.board.occupancy()); },
+        make_visit_move<context, PieceType::QUEEN>(visitor), visit_group, check_mask...);
+  };
+  visit_queen_move_groups(~hv_pin_mask, dg_pin_mask, bishop_attack_set);
+  visit_queen_move_groups(~dg_pin_mask, hv_pin_mask, rook_attack_set);
+}
+
+template <Node::Context context, typename T>
+void visit_non_king_move_groups(const Node& node, const Constraints& constraints, Visitor<T>& visitor,
+                                const auto& visit_group, const std::same_as<Bitboard> auto... check_mask) {
+  const auto dg_pin_mask = constraints.dg_pin_mask;
+  const auto hv_pin_mask = constraints.hv_pin_mask;
+  visit_pawn_move_groups<context>(node, dg_pin_mask, hv_pin_mask, make_visit_move<context, PieceType::PAWN>(visitor),
+                                  make_visit_double_push<context>(node.board, visitor), visit_group, check_mask...);
+  visit_piece_move_groups<context.side_to_move, context.castling_rights, PieceType::KNIGHT>(
+      node.board, ~(dg_pin_mask | hv_pin_mask), Bitboard(), knight_attack_set,
+      make_visit_move<context, PieceType::KNIGHT>(visitor), visit_group, check_mask...);
+  visit_slider_move_groups<context>(node, constraints, visitor, visit_group, check_mask...);
+}
+
+// A decode kept past its group's visit, in place since decodes are a few words of bitboards and references.
+class GroupDecode {
+ public:
+  GroupDecode() noexcept = default;
+
+  template <typename Decode>
+  explicit GroupDecode(const Decode& decode) noexcept
+      : decode_([](const std::byte* storage, const int index) {
+          (*std::launder(reinterpret_cast<const Decode*>(storage)))(index);
+        }) {
+    static_assert(sizeof(Decode) <= STORAGE_SIZE && alignof(Decode) <= alignof(std::max_align_t));
+    static_assert(std::is_trivially_copyable_v<Decode> && std::is_trivially_destructible_v<Decode>);
+    std::construct_at(reinterpret_cast<Decode*>(storage_.data()), decode);
+  }
+
+  void operator()(const int index) const { decode_(storage_.data(), index); }
+
+ private:
+  static constexpr auto STORAGE_SIZE = 64UZ;
+
+  alignas(std::max_align_t) std::array<std::byte, STORAGE_SIZE> storage_;
+  void (*decode_)(const std::byte*, int) = nullptr;
+};
+
+// Non-empty groups: one for the king's moves, one for castles, one per origin of the other pieces and two for each
+// queen, and at most 15 for pawns.
+inline constexpr auto MAX_GROUP_COUNT = 64UZ;
+
+template <Node::Context context, typename T>
+void visit_move_groups(const Node& node, const Constraints& constraints, Visitor<T>& visitor,
+                       const auto& visit_group) {
+  const auto visit_king_move = make_visit_move<context, PieceType::KING>(visitor);
+  const auto king_targets = king_attack_set(constraints.king_origin) & ~constraints.king_danger_set &
+                            ~node.board[context.side_to_move];
+  visit_group(popcount(king_targets), [&node, king_targets, visit_king_move](const auto index) {
+    walk_non_pawn_quiet_moves_and_captures<context.side_to_move, context.castling_rights, PieceType::KING,
+                                           Stage::ALL>(node.board, node.board[context.side_to_move, PieceType::KING],
+                                                       nth_bit(king_targets, index), visit_king_move);
+  });
+  int castle_count = 0;
+  walk_castles<context>(node, constraints.king_danger_set, [&]<auto>(const auto&) { ++castle_count; });
+  visit_group(castle_count, [&node, king_danger_set = constraints.king_danger_set, visit_king_move](auto index) {
+    walk_castles<context>(node, king_danger_set, [&]<auto new_castling_rights>(const auto& move) {
+      if (index-- == 0) {
+        visit_king_move.template operator()<new_castling_rights>(move);
+      }
+    });
+  });
+  switch (popcount(constraints.checkers)) {
+    case 0:
+      visit_non_king_move_groups<context>(node, constraints, visitor, visit_group);
+      break;
+    case 1:
+      visit_non_king_move_groups<context>(node, constraints, visitor, visit_group,
+                                          half_open_segment(square_of(constraints.checkers), constraints.king_origin));
+      break;
+    default:
+      break;
+  }
+}
+}  // namespace prodigy::move_generator
+
+export namespace prodigy::move_generator {
+// Visits one legal move drawn uniformly at random and returns the number of legal moves, visiting nothing if there
+// are none. Unlike walk, only the drawn move is decoded.
+template <Node::Context context, typename T>
+int sample(const Node& node, std::uniform_random_bit_generator auto& generator, Visitor<T>&& visitor) {
+  const auto constraints = make_constraints<context.side_to_move>(node.board);
+  // Each group's count and decode are kept, so the legal moves are generated once and only the drawn one is decoded.
+  struct Group {
+    int move_count;
+    GroupDecode decode;
+  };
+  std::array<Group, MAX_GROUP_COUNT> groups;
+  auto group_count = 0UZ;
+  int move_count = 0;
+  visit_move_groups<context>(node, constraints, visitor, [&](const int group_move_count, const auto& decode) {
+    if (group_move_count > 0) {
+      assert(group_count < groups.size());
+      groups[group_count++] = {group_move_count, GroupDecode(decode)};
+      move_count += group_move_count;
+    }
+  });
+  if (move_count > 0) {
+    auto index = std::uniform_int_distribution(0, move_count - 1)(generator);
+    for (const auto& [group_move_count, decode] : std::span(groups).first(group_count)) {
+      if (index < group_move_count) {
+        decode(index);
+        break;
+      }
+      index -= group_move_count;
+    }
+  }
+  if (any(constraints.checkers)) {
+    visitor.is_check();
+  }
+  return move_count;
+}
+}  // namespace prodigy::move_generator
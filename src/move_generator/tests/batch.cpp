@@ -0,0 +1,103 @@
+#include <catch2/catch_test_macros.hpp>
+#include <string_view>
+#include <vector>
+
+import prodigy.core;
+import prodigy.move_generator;
+
+namespace prodigy::move_generator {
+namespace {
+class Visitor : public move_generator::Visitor<Visitor> {
+ public:
+  constexpr explicit Visitor(int& move_count) noexcept : move_count_(move_count) {}
+
+  template <Node::Context>
+  constexpr void visit_pawn_move(const auto&) const noexcept {
+    ++move_count_;
+  }
+
+  template <Node::Context>
+  constexpr void visit_knight_move(const auto&) const noexcept {
+    ++move_count_;
+  }
+
+  template <Node::Context>
+  constexpr void visit_bishop_move(const auto&) const noexcept {
+    ++move_count_;
+  }
+
+  template <Node::Context>
+  constexpr void visit_rook_move(const auto&) const noexcept {
+    ++move_count_;
+  }
+
+  template <Node::Context>
+  constexpr void visit_queen_move(const auto&) const noexcept {
+    ++move_count_;
+  }
+
+  template <Node::Context>
+  constexpr void visit_king_move(const auto&) const noexcept {
+    ++move_count_;
+  }
+
+  constexpr void is_check() const noexcept {}
+
+ private:
+  int& move_count_;
+};
+
+TEST_CASE("batch") {
+  static_cast<void>(init());
+  const auto validate = [&]<Color side_to_move>(const std::vector<std::string_view>& fens) {
+    std::vector<Position> positions;
+    std::vector<Board> boards;
+    for (const auto fen : fens) {
+      positions.push_back(parse_fen(fen).value());
+      REQUIRE(positions.back().side_to_move == side_to_move);
+      boards.push_back(positions.back().board);
+    }
+    std::vector<Constraints> constraints(boards.size());
+    make_constraints<side_to_move>(boards, constraints);
+    std::vector<int> move_counts(positions.size());
+    count_moves<side_to_move>(positions, move_counts);
+    for (auto i = 0UZ; i < positions.size(); ++i) {
+      INFO(fens[i]);
+      const auto expected_constraints = make_constraints<side_to_move>(boards[i]);
+      REQUIRE(constraints[i].king_origin == expected_constraints.king_origin);
+      REQUIRE(constraints[i].king_danger_set == expected_constraints.king_danger_set);
+      REQUIRE(constraints[i].checkers == expected_constraints.checkers);
+      REQUIRE(constraints[i].dg_pin_mask == expected_constraints.dg_pin_mask);
+      REQUIRE(constraints[i].hv_pin_mask == expected_constraints.hv_pin_mask);
+      dispatch(positions[i], [&]<auto context>(const auto& node) {
+        int move_count = 0;
+        walk<context>(node, Visitor(move_count));
+        REQUIRE(count_moves<context>(node, constraints[i]) == move_count);
+        REQUIRE(move_counts[i] == move_count);
+      });
+    }
+  };
+  validate.operator()<Color::WHITE>({
+      STARTING_FEN,
+      KIWIPETE,
+      "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+      "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+      "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+      "7k/8/8/3pP3/4K3/8/8/8 w - d6 0 1",
+      "4k3/8/8/8/1b6/8/3N4/4K2q w - - 0 1",
+      "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1",
+      "K7/8/8/3Q4/4q3/8/8/7k w - - 0 1",
+      "4k3/8/8/8/1b6/5n2/3N4/4K2r w - - 0 1",
+      "4k3/8/8/8/8/2b5/3P4/4K3 w - - 0 1",
+      "4r3/8/8/8/8/8/4P3/4K3 w - - 0 1",
+  });
+  validate.operator()<Color::BLACK>({
+      "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1",
+      "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b KQkq - 0 1",
+      "4r3/8/8/8/8/8/4n3/R3k2K b - - 0 1",
+      "8/8/8/8/k2Pp2Q/8/8/3K4 b - d3 0 1",
+  });
+}
+}  // namespace
+}  // namespace prodigy::move_generator
@@ -12,7 +12,8 @@ TEST_CASE("dispatch") {
   };
   {
     static constexpr auto node = to_node(STARTING_POSITION);
-    STATIC_REQUIRE(node.first == Node{STARTING_POSITION.board, STARTING_POSITION.en_passant_victim_origin});
+    STATIC_REQUIRE(node.first == Node{STARTING_POSITION.board, STARTING_POSITION.en_passant_victim_origin,
+                                         STARTING_POSITION.castling_rights});
     STATIC_REQUIRE(node.second ==
                    Node::Context{
                        .side_to_move = Color::WHITE,
@@ -24,10 +25,15 @@ TEST_CASE("dispatch") {
   {
     static constexpr auto position = parse_fen("8/8/8/8/8/8/8/8 b - e3 0 1").value();
     static constexpr auto node = to_node(position);
-    STATIC_REQUIRE(node.first == Node{position.board, position.en_passant_victim_origin});
+    STATIC_REQUIRE(node.first == Node{position.board, position.en_passant_victim_origin, position.castling_rights});
     STATIC_REQUIRE(node.second == Node::Context{
                                       .side_to_move = Color::BLACK,
-                                      .castling_rights = CastlingRights(),
+                                      .castling_rights = RUNTIME_CASTLING_RIGHTS
+                                                             ? CastlingRights::WHITE_KINGSIDE |
+                                                                   CastlingRights::WHITE_QUEENSIDE |
+                                                                   CastlingRights::BLACK_KINGSIDE |
+                                                                   CastlingRights::BLACK_QUEENSIDE
+                                                             : CastlingRights(),
                                       .can_en_passant = true,
                                   });
   }
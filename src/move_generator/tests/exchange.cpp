@@ -0,0 +1,113 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <string_view>
+
+import prodigy.core;
+import prodigy.move_generator;
+
+namespace prodigy::move_generator {
+namespace {
+TEST_CASE("attackers to") {
+  static_cast<void>(init());
+  const auto& board = STARTING_POSITION.board;
+  REQUIRE(attackers_to(board, Square::F3, board.occupancy()) ==
+          (to_bitboard(Square::E2) | to_bitboard(Square::G2) | to_bitboard(Square::G1)));
+  REQUIRE(attackers_to(board, Square::D6, board.occupancy()) ==
+          (to_bitboard(Square::C7) | to_bitboard(Square::E7)));
+  REQUIRE(attackers_to(board, Square::E2, board.occupancy()) ==
+          (to_bitboard(Square::D1) | to_bitboard(Square::E1) | to_bitboard(Square::F1) | to_bitboard(Square::G1)));
+  REQUIRE(attackers_to(board, Square::E4, board.occupancy()) == Bitboard());
+  REQUIRE(attackers_to(board, Square::E4, board.occupancy() ^ to_bitboard(Square::E2)) == Bitboard());
+  REQUIRE(attackers_to(board, Square::D3, board.occupancy() ^ to_bitboard(Square::D2)) ==
+          (to_bitboard(Square::C2) | to_bitboard(Square::E2) | to_bitboard(Square::D1)));
+}
+
+TEST_CASE("see") {
+  const auto [fen, context, move, expected_gain] = GENERATE(table<std::string_view, std::string_view, Capture, int>({
+      {
+          "1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1",
+          "undefended pawn",
+          {
+              .origin = to_bitboard(Square::E1),
+              .target = to_bitboard(Square::E5),
+              .aggressor = PieceType::ROOK,
+              .victim = PieceType::PAWN,
+          },
+          100,
+      },
+      {
+          "4k3/8/3p4/4p3/3P4/8/8/4K3 w - - 0 1",
+          "even trade",
+          {
+              .origin = to_bitboard(Square::D4),
+              .target = to_bitboard(Square::E5),
+              .aggressor = PieceType::PAWN,
+              .victim = PieceType::PAWN,
+          },
+          0,
+      },
+      {
+          "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1",
+          "x-rayed recaptures",
+          {
+              .origin = to_bitboard(Square::D3),
+              .target = to_bitboard(Square::E5),
+              .aggressor = PieceType::KNIGHT,
+              .victim = PieceType::PAWN,
+          },
+          -200,
+      },
+      {
+          "4k3/3r4/8/3p4/8/8/3R4/3RK3 w - - 0 1",
+          "x-rayed rook",
+          {
+              .origin = to_bitboard(Square::D2),
+              .target = to_bitboard(Square::D5),
+              .aggressor = PieceType::ROOK,
+              .victim = PieceType::PAWN,
+          },
+          100,
+      },
+      {
+          "8/8/4k3/3p4/8/8/3R4/6K1 w - - 0 1",
+          "defended by king",
+          {
+              .origin = to_bitboard(Square::D2),
+              .target = to_bitboard(Square::D5),
+              .aggressor = PieceType::ROOK,
+              .victim = PieceType::PAWN,
+          },
+          -400,
+      },
+      {
+          "8/8/4k3/3p4/8/8/3R4/3R2K1 w - - 0 1",
+          "king cannot recapture",
+          {
+              .origin = to_bitboard(Square::D2),
+              .target = to_bitboard(Square::D5),
+              .aggressor = PieceType::ROOK,
+              .victim = PieceType::PAWN,
+          },
+          100,
+      },
+      {
+          "8/8/8/3p4/4K3/8/8/7k w - - 0 1",
+          "king captures",
+          {
+              .origin = to_bitboard(Square::E4),
+              .target = to_bitboard(Square::D5),
+              .aggressor = PieceType::KING,
+              .victim = PieceType::PAWN,
+          },
+          100,
+      },
+  }));
+  static_cast<void>(init());
+  INFO(fen);
+  INFO(context);
+  const auto position = parse_fen(fen).value();
+  REQUIRE(position.side_to_move == Color::WHITE);
+  REQUIRE(see<Color::WHITE>(position.board, move) == expected_gain);
+}
+}  // namespace
+}  // namespace prodigy::move_generator
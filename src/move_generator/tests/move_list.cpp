@@ -0,0 +1,88 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+import prodigy.core;
+import prodigy.move_generator;
+
+namespace prodigy::move_generator {
+namespace {
+using Key = std::tuple<Hash, Color, CastlingRights, bool>;
+
+template <Node::Context child_context>
+Key key(const Node& child) noexcept {
+  return Key(hash<child_context>(child), child_context.side_to_move, castling_rights_of<child_context>(child),
+             child_context.can_en_passant);
+}
+
+class Visitor : public move_generator::Visitor<Visitor> {
+ public:
+  constexpr explicit Visitor(Node& node, std::vector<Key>& keys) noexcept : node_(node), keys_(keys) {}
+
+  template <Node::Context child_context>
+  void visit_pawn_move(const auto& move) const {
+    visit<child_context>(move);
+  }
+
+  template <Node::Context child_context>
+  void visit_knight_move(const auto& move) const {
+    visit<child_context>(move);
+  }
+
+  template <Node::Context child_context>
+  void visit_bishop_move(const auto& move) const {
+    visit<child_context>(move);
+  }
+
+  template <Node::Context child_context>
+  void visit_rook_move(const auto& move) const {
+    visit<child_context>(move);
+  }
+
+  template <Node::Context child_context>
+  void visit_queen_move(const auto& move) const {
+    visit<child_context>(move);
+  }
+
+  template <Node::Context child_context>
+  void visit_king_move(const auto& move) const {
+    visit<child_context>(move);
+  }
+
+  constexpr void is_check() const noexcept {}
+
+ private:
+  template <Node::Context child_context>
+  void visit(const auto& move) const {
+    const auto undo = scoped_move<!child_context.side_to_move, child_context.can_en_passant>(node_, move);
+    keys_.push_back(key<child_context>(node_));
+  }
+
+  Node& node_;
+  std::vector<Key>& keys_;
+};
+
+TEST_CASE("move list") {
+  const auto fen = GENERATE(as<std::string_view>(), STARTING_FEN, KIWIPETE, "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+                            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", "7k/8/8/3pP3/4K3/8/8/8 w - d6 0 1",
+                            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+                            "R6R/3Q4/1Q4Q1/4Q3/2Q4Q/Q4Q2/pp1Q4/kBNN1KB1 w - - 0 1");
+  static_cast<void>(init());
+  INFO(fen);
+  dispatch(parse_fen(fen).value(), [&]<auto context>(auto node) {
+    std::vector<Key> expected_keys;
+    walk<context>(node, Visitor(node, expected_keys));
+    const auto moves = make_move_list<context>(node);
+    REQUIRE(moves.size() == expected_keys.size());
+    std::vector<Key> keys;
+    for (const auto move : moves) {
+      apply<context>(node, move,
+                     [&]<auto child_context>(const Node& child) { keys.push_back(key<child_context>(child)); });
+    }
+    REQUIRE(keys == expected_keys);
+  });
+}
+}  // namespace
+}  // namespace prodigy::move_generator
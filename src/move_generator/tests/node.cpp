@@ -40,10 +40,36 @@ TEST_CASE("move") {
   validate([]<auto context, auto child_castling_rights> {
     STATIC_REQUIRE(context.move(child_castling_rights) == Node::Context{
                                                               .side_to_move = !context.side_to_move,
-                                                              .castling_rights = child_castling_rights,
+                                                              .castling_rights = RUNTIME_CASTLING_RIGHTS
+                                                                                     ? context.castling_rights
+                                                                                     : child_castling_rights,
                                                               .can_en_passant = false,
                                                           });
   });
 }
+
+TEST_CASE("update_castling_rights") {
+  static constexpr auto castling_rights = CastlingRights::WHITE_KINGSIDE | CastlingRights::WHITE_QUEENSIDE |
+                                          CastlingRights::BLACK_KINGSIDE | CastlingRights::BLACK_QUEENSIDE;
+  STATIC_REQUIRE(update_castling_rights(castling_rights, QuietMove{
+                                                             .origin = to_bitboard(Square::E2),
+                                                             .target = to_bitboard(Square::E4),
+                                                             .piece_type = PieceType::PAWN,
+                                                         }) == castling_rights);
+  STATIC_REQUIRE(update_castling_rights(castling_rights, QuietMove{
+                                                             .origin = to_bitboard(Square::H1),
+                                                             .target = to_bitboard(Square::G1),
+                                                             .piece_type = PieceType::ROOK,
+                                                         }) == (castling_rights & ~CastlingRights::WHITE_KINGSIDE));
+  STATIC_REQUIRE(update_castling_rights(castling_rights, Capture{
+                                                             .origin = to_bitboard(Square::A1),
+                                                             .target = to_bitboard(Square::A8),
+                                                             .aggressor = PieceType::ROOK,
+                                                             .victim = PieceType::ROOK,
+                                                         }) ==
+                 (CastlingRights::WHITE_KINGSIDE | CastlingRights::BLACK_KINGSIDE));
+  STATIC_REQUIRE(update_castling_rights(castling_rights, ColorTraits<Color::BLACK>::QUEENSIDE_CASTLE) ==
+                 (CastlingRights::WHITE_KINGSIDE | CastlingRights::WHITE_QUEENSIDE));
+}
 }  // namespace
 }  // namespace prodigy::move_generator
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <cmath>
+#include <concepts>
+#include <map>
+#include <random>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+import prodigy.core;
+import prodigy.move_generator;
+
+namespace prodigy::move_generator {
+namespace {
+using Key = std::tuple<Bitboard, Bitboard, PieceType, Color, CastlingRights, bool>;
+
+class Visitor : public move_generator::Visitor<Visitor> {
+ public:
+  constexpr explicit Visitor(std::vector<Key>& keys, bool& is_check) noexcept : keys_(keys), is_check_(is_check) {}
+
+  template <Node::Context child_context>
+  void visit_pawn_move(const auto& move) const {
+    record<child_context>(move, PieceType::PAWN);
+  }
+
+  template <Node::Context child_context>
+  void visit_knight_move(const auto& move) const {
+    record<child_context>(move, PieceType::KNIGHT);
+  }
+
+  template <Node::Context child_context>
+  void visit_bishop_move(const auto& move) const {
+    record<child_context>(move, PieceType::BISHOP);
+  }
+
+  template <Node::Context child_context>
+  void visit_rook_move(const auto& move) const {
+    record<child_context>(move, PieceType::ROOK);
+  }
+
+  template <Node::Context child_context>
+  void visit_queen_move(const auto& move) const {
+    record<child_context>(move, PieceType::QUEEN);
+  }
+
+  template <Node::Context child_context>
+  void visit_king_move(const auto& move) const {
+    record<child_context>(move, PieceType::KING);
+  }
+
+  void is_check() const noexcept { is_check_ = true; }
+
+ private:
+  template <Node::Context child_context>
+  void record(const auto& move, const PieceType piece_type) const {
+    const auto key = [](const auto origin, const auto target, const auto moved_piece_type) {
+      return Key(origin, target, moved_piece_type, child_context.side_to_move, child_context.castling_rights,
+                 child_context.can_en_passant);
+    };
+    if constexpr (std::derived_from<std::remove_cvref_t<decltype(move)>, Castle>) {
+      keys_.push_back(key(move.king_origin, move.king_target, piece_type));
+    } else if constexpr (requires { move.promotion; }) {
+      keys_.push_back(key(move.origin, move.target, move.promotion));
+    } else {
+      keys_.push_back(key(move.origin, move.target, piece_type));
+    }
+  }
+
+  std::vector<Key>& keys_;
+  bool& is_check_;
+};
+
+TEST_CASE("sample") {
+  const auto fen = GENERATE(as<std::string_view>(), STARTING_FEN, KIWIPETE, "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+                            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", "7k/8/8/3pP3/4K3/8/8/8 w - d6 0 1",
+                            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+                            "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3");
+  static_cast<void>(init());
+  INFO(fen);
+  dispatch(parse_fen(fen).value(), [&]<auto context>(const auto& node) {
+    std::vector<Key> keys;
+    bool is_check = false;
+    walk<context>(node, Visitor(keys, is_check));
+    std::map<Key, int> frequencies;
+    for (const auto& key : keys) {
+      frequencies.emplace(key, 0);
+    }
+    REQUIRE(frequencies.size() == keys.size());
+    const auto move_count = static_cast<int>(keys.size());
+    static constexpr auto expected_frequency = 1000;
+    const auto sample_count = expected_frequency * move_count;
+    std::mt19937_64 generator;
+    for (auto i = 0; i < std::max(sample_count, 1); ++i) {
+      std::vector<Key> sampled_keys;
+      bool sampled_is_check = false;
+      REQUIRE(sample<context>(node, generator, Visitor(sampled_keys, sampled_is_check)) == move_count);
+      REQUIRE(sampled_is_check == is_check);
+      if (move_count == 0) {
+        REQUIRE(sampled_keys.empty());
+        continue;
+      }
+      REQUIRE(sampled_keys.size() == 1);
+      const auto it = frequencies.find(sampled_keys.front());
+      REQUIRE(it != frequencies.end());
+      ++it->second;
+    }
+    if (move_count > 1) {
+      auto chi_squared = 0.0;
+      for (const auto& [_, frequency] : frequencies) {
+        chi_squared += std::pow(frequency - expected_frequency, 2) / expected_frequency;
+      }
+      // Six standard deviations above the mean of the chi-squared distribution.
+      const auto degrees_of_freedom = static_cast<double>(move_count - 1);
+      REQUIRE(chi_squared < degrees_of_freedom + 6 * std::sqrt(2 * degrees_of_freedom));
+    }
+  });
+}
+}  // namespace
+}  // namespace prodigy::move_generator
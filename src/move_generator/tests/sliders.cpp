@@ -0,0 +1,30 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <random>
+#include <utility>
+
+import prodigy.core;
+import prodigy.move_generator;
+
+namespace prodigy::move_generator {
+namespace {
+// Kogge-Stone fills are only used when built with PRODIGY_KOGGE_STONE_SLIDERS, but are checked against the magic
+// lookups in every build. Sparse and dense occupancies block rays near and far from the origin.
+TEST_CASE("Kogge-Stone") {
+  static_cast<void>(init());
+  std::mt19937_64 generator;
+  for (std::uint8_t i = 0; i < 64; ++i) {
+    const auto origin = static_cast<Square>(i);
+    for (auto j = 0; j < 256; ++j) {
+      const auto occupancy = Bitboard{j % 2 == 0 ? generator() & generator() : generator() | generator()};
+      INFO(static_cast<int>(i));
+      INFO(std::to_underlying(occupancy));
+      REQUIRE(BishopKoggeStone::attack_set(origin, occupancy) == BishopMagicBitboards::attack_set(origin, occupancy));
+      REQUIRE(RookKoggeStone::attack_set(origin, occupancy) == RookMagicBitboards::attack_set(origin, occupancy));
+    }
+    REQUIRE(BishopKoggeStone::attack_set(origin, Bitboard()) == BishopMagicBitboards::attack_set(origin, Bitboard()));
+    REQUIRE(RookKoggeStone::attack_set(origin, Bitboard()) == RookMagicBitboards::attack_set(origin, Bitboard()));
+  }
+}
+}  // namespace
+}  // namespace prodigy::move_generator
@@ -11,7 +11,7 @@ constexpr Position to_position(const Node& node, const Ply halfmove_clock) noexc
   return {
       .board = node.board,
       .side_to_move = child_context.side_to_move,
-      .castling_rights = child_context.castling_rights,
+      .castling_rights = castling_rights_of<child_context>(node),
       .en_passant_victim_origin = node.en_passant_victim_origin,
       .halfmove_clock = halfmove_clock,
       .fullmove_number = 1,
@@ -72,6 +72,7 @@ class Visitor : public move_generator::Visitor<Visitor> {
     INFO(fen);
     const auto undo = scoped_move<!child_context.side_to_move, child_context.can_en_passant>(node_, move);
     REQUIRE(to_position<child_context>(node_, halfmove_clock) == parse_fen(fen).value());
+    REQUIRE(hash<child_context>(node_) == parse_fen(fen).value().hash());
   }
 
   Node& node_;
@@ -1,6 +1,7 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators.hpp>
 #include <cstdint>
+#include <optional>
 #include <string_view>
 #include <utility>
 
@@ -130,6 +131,51 @@ class Visitor : public move_generator::Visitor<Visitor> {
   MoveCounts& move_counts_;
 };
 
+class ConstraintsVisitor : public move_generator::Visitor<ConstraintsVisitor> {
+ public:
+  constexpr explicit ConstraintsVisitor(std::optional<Constraints>& constraints) noexcept : constraints_(constraints) {}
+
+  template <Node::Context>
+  void visit_pawn_move(const auto&) const noexcept {
+    REQUIRE(constraints_.has_value());
+  }
+
+  template <Node::Context>
+  void visit_knight_move(const auto&) const noexcept {
+    REQUIRE(constraints_.has_value());
+  }
+
+  template <Node::Context>
+  void visit_bishop_move(const auto&) const noexcept {
+    REQUIRE(constraints_.has_value());
+  }
+
+  template <Node::Context>
+  void visit_rook_move(const auto&) const noexcept {
+    REQUIRE(constraints_.has_value());
+  }
+
+  template <Node::Context>
+  void visit_queen_move(const auto&) const noexcept {
+    REQUIRE(constraints_.has_value());
+  }
+
+  template <Node::Context>
+  void visit_king_move(const auto&) const noexcept {
+    REQUIRE(constraints_.has_value());
+  }
+
+  void is_check() const noexcept {}
+
+  void visit_constraints(const Constraints& constraints) const noexcept {
+    REQUIRE_FALSE(constraints_.has_value());
+    constraints_ = constraints;
+  }
+
+ private:
+  std::optional<Constraints>& constraints_;
+};
+
 TEST_CASE("walk") {
   const auto [fen, context, expected_move_counts] = GENERATE(table<std::string_view, std::string_view, MoveCounts>({
       {
@@ -530,5 +576,64 @@ TEST_CASE("walk") {
     REQUIRE(move_counts == expected_move_counts);
   });
 }
+
+TEST_CASE("staged walk") {
+  const auto fen = GENERATE(as<std::string_view>(), STARTING_FEN, KIWIPETE, "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+                            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", "7k/8/8/3pP3/4K3/8/8/8 w - d6 0 1",
+                            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+  static_cast<void>(init());
+  INFO(fen);
+  dispatch(parse_fen(fen).value(), [&]<auto context>(const auto& node) {
+    MoveCounts all{};
+    walk<context>(node, Visitor(all));
+    const auto constraints = make_constraints<context.side_to_move>(node.board);
+    MoveCounts captures{};
+    walk<context, Stage::CAPTURES>(node, constraints, Visitor(captures));
+    MoveCounts quiets{};
+    walk<context, Stage::QUIETS>(node, constraints, Visitor(quiets));
+    REQUIRE(captures == MoveCounts{
+                            .pawn_captures = all.pawn_captures,
+                            .quiet_promotions = all.quiet_promotions,
+                            .capture_promotions = all.capture_promotions,
+                            .en_passants = all.en_passants,
+                            .knight_captures = all.knight_captures,
+                            .bishop_captures = all.bishop_captures,
+                            .rook_captures = all.rook_captures,
+                            .queen_captures = all.queen_captures,
+                            .king_captures = all.king_captures,
+                            .is_check = all.is_check,
+                        });
+    REQUIRE(quiets == MoveCounts{
+                          .pawn_single_pushes = all.pawn_single_pushes,
+                          .pawn_double_pushes = all.pawn_double_pushes,
+                          .knight_quiet_moves = all.knight_quiet_moves,
+                          .bishop_quiet_moves = all.bishop_quiet_moves,
+                          .rook_quiet_moves = all.rook_quiet_moves,
+                          .queen_quiet_moves = all.queen_quiet_moves,
+                          .king_quiet_moves = all.king_quiet_moves,
+                          .kingside_castles = all.kingside_castles,
+                          .queenside_castles = all.queenside_castles,
+                          .is_check = all.is_check,
+                      });
+  });
+}
+
+TEST_CASE("visit_constraints") {
+  const auto fen = GENERATE(as<std::string_view>(), KIWIPETE, "8/8/8/k7/2p5/8/3P4/4b2K w - - 0 1",
+                            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+  static_cast<void>(init());
+  INFO(fen);
+  dispatch(parse_fen(fen).value(), [&]<auto context>(const auto& node) {
+    std::optional<Constraints> constraints;
+    walk<context>(node, ConstraintsVisitor(constraints));
+    REQUIRE(constraints.has_value());
+    const auto expected_constraints = make_constraints<context.side_to_move>(node.board);
+    REQUIRE(constraints->king_origin == expected_constraints.king_origin);
+    REQUIRE(constraints->king_danger_set == expected_constraints.king_danger_set);
+    REQUIRE(constraints->checkers == expected_constraints.checkers);
+    REQUIRE(constraints->dg_pin_mask == expected_constraints.dg_pin_mask);
+    REQUIRE(constraints->hv_pin_mask == expected_constraints.hv_pin_mask);
+  });
+}
 }  // namespace
 }  // namespace prodigy::move_generator
@@ -70,14 +70,29 @@ class Visitor {
   template <Color side_to_move, bool enable_en_passant, typename Move>
   static constexpr auto scoped_move(Node& node, const Move& move) noexcept {
     node.board.apply<side_to_move>(move);
+    const auto undo_castling_rights = [&] {
+      if constexpr (RUNTIME_CASTLING_RIGHTS) {
+        return [&node, castling_rights = std::exchange(node.castling_rights,
+                                                       update_castling_rights(node.castling_rights, move))] {
+          node.castling_rights = castling_rights;
+        };
+      } else {
+        return [] {};
+      }
+    }();
     if constexpr (enable_en_passant) {
       static_assert(std::same_as<Move, QuietMove>);
-      return AutoUndo([&, en_passant_victim_origin = std::exchange(node.en_passant_victim_origin, move.target)] {
+      return AutoUndo([&, undo_castling_rights,
+                       en_passant_victim_origin = std::exchange(node.en_passant_victim_origin, move.target)] {
         node.board.apply<side_to_move>(move);
         node.en_passant_victim_origin = en_passant_victim_origin;
+        undo_castling_rights();
       });
     } else {
-      return AutoUndo([&] { node.board.apply<side_to_move>(move); });
+      return AutoUndo([&, undo_castling_rights] {
+        node.board.apply<side_to_move>(move);
+        undo_castling_rights();
+      });
     }
   }
 };
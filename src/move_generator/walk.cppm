@@ -1,6 +1,7 @@
 module;
 
 #include <concepts>
+#include <cstdint>
 #include <initializer_list>
 #include <utility>
 
@@ -12,18 +13,31 @@ import :lookup;
 import :node;
 import :visitor;
 
+export namespace prodigy::move_generator {
+enum class Stage : std::uint8_t {
+  ALL,
+  // Captures, en passants and promotions.
+  CAPTURES,
+  // Everything else, including castles.
+  QUIETS,
+};
+
+struct Constraints {
+  Square king_origin;
+  Bitboard king_danger_set;
+  Bitboard checkers;
+  // Empty in double check, where only the king moves.
+  Bitboard dg_pin_mask;
+  Bitboard hv_pin_mask;
+};
+}  // namespace prodigy::move_generator
+
 namespace prodigy::move_generator {
 template <Color side_to_move>
 constexpr void for_each_capture(const Board& board, const Bitboard targets,
                                 const std::invocable<Bitboard, PieceType> auto& callback) {
-  for_each_bit(targets, [&](const auto target) {
-    for (const auto piece_type : {PieceType::PAWN, PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK}) {
-      if (any(board[!side_to_move, piece_type] & target)) {
-        callback(target, piece_type);
-        return;
-      }
-    }
-    callback(target, PieceType::QUEEN);
+  for_each_bit_and_square(targets, [&](const auto target_bit, const auto target_square) {
+    callback(target_bit, board.piece_at(target_square)->second);
   });
 }
 
@@ -49,54 +63,61 @@ constexpr void for_each_capture(const Board& board, Bitboard targets, const auto
   });
 }
 
-template <Color side_to_move, CastlingRights castling_rights, PieceType piece_type>
+template <Color side_to_move, CastlingRights castling_rights, PieceType piece_type, Stage stage>
 constexpr void walk_non_pawn_quiet_moves_and_captures(const Board& board, const Bitboard origin,
                                                       const Bitboard attack_set, const auto& visit_move) {
-  for_each_bit(attack_set & ~board.occupancy(), [&](const auto target) {
-    visit_move.template operator()<castling_rights>(QuietMove{
-        .origin = origin,
-        .target = target,
-        .piece_type = piece_type,
+  if constexpr (stage != Stage::CAPTURES) {
+    for_each_bit(attack_set & ~board.occupancy(), [&](const auto target) {
+      visit_move.template operator()<castling_rights>(QuietMove{
+          .origin = origin,
+          .target = target,
+          .piece_type = piece_type,
+      });
     });
-  });
-  for_each_capture<side_to_move, castling_rights>(board, attack_set & board[!side_to_move],
-                                                  [&]<auto new_castling_rights>(const auto target, const auto victim) {
-                                                    visit_move.template operator()<new_castling_rights>(Capture{
-                                                        .origin = origin,
-                                                        .target = target,
-                                                        .aggressor = piece_type,
-                                                        .victim = victim,
-                                                    });
-                                                  });
+  }
+  if constexpr (stage != Stage::QUIETS) {
+    for_each_capture<side_to_move, castling_rights>(
+        board, attack_set & board[!side_to_move], [&]<auto new_castling_rights>(const auto target, const auto victim) {
+          visit_move.template operator()<new_castling_rights>(Capture{
+              .origin = origin,
+              .target = target,
+              .aggressor = piece_type,
+              .victim = victim,
+          });
+        });
+  }
 }
 
-template <Color side_to_move, CastlingRights castling_rights>
-void walk_king_moves(const Board& board, const Square king_origin, const auto& visit_move) {
-  const auto king_danger_set = [&] {
-    auto king_danger_set = pawn_left_attack_set(!side_to_move, board[!side_to_move, PieceType::PAWN]) |
-                           pawn_right_attack_set(!side_to_move, board[!side_to_move, PieceType::PAWN]) |
-                           king_attack_set(square_of(board[!side_to_move, PieceType::KING]));
-    for_each_square(board[!side_to_move, PieceType::KNIGHT],
-                    [&](const auto origin) { king_danger_set |= knight_attack_set(origin); });
-    const auto kingless_occupancy = board.occupancy() ^ board[side_to_move, PieceType::KING];
-    for_each_square(board[!side_to_move, PieceType::BISHOP] | board[!side_to_move, PieceType::QUEEN],
-                    [&](const auto origin) { king_danger_set |= bishop_attack_set(origin, kingless_occupancy); });
-    for_each_square(board[!side_to_move, PieceType::ROOK] | board[!side_to_move, PieceType::QUEEN],
-                    [&](const auto origin) { king_danger_set |= rook_attack_set(origin, kingless_occupancy); });
-    return king_danger_set;
-  }();
-  walk_non_pawn_quiet_moves_and_captures<side_to_move, castling_rights, PieceType::KING>(
-      board, board[side_to_move, PieceType::KING], king_attack_set(king_origin) & ~king_danger_set, visit_move);
-  using ColorTraits = ColorTraits<side_to_move>;
+template <Color side_to_move>
+Bitboard make_king_danger_set(const Board& board) noexcept {
+  auto king_danger_set = pawn_left_attack_set(!side_to_move, board[!side_to_move, PieceType::PAWN]) |
+                         pawn_right_attack_set(!side_to_move, board[!side_to_move, PieceType::PAWN]) |
+                         king_attack_set(square_of(board[!side_to_move, PieceType::KING]));
+  for_each_square(board[!side_to_move, PieceType::KNIGHT],
+                  [&](const auto origin) { king_danger_set |= knight_attack_set(origin); });
+  const auto kingless_occupancy = board.occupancy() ^ board[side_to_move, PieceType::KING];
+  for_each_square(board[!side_to_move, PieceType::BISHOP] | board[!side_to_move, PieceType::QUEEN],
+                  [&](const auto origin) { king_danger_set |= bishop_attack_set(origin, kingless_occupancy); });
+  for_each_square(board[!side_to_move, PieceType::ROOK] | board[!side_to_move, PieceType::QUEEN],
+                  [&](const auto origin) { king_danger_set |= rook_attack_set(origin, kingless_occupancy); });
+  return king_danger_set;
+}
+
+// Castling rights are checked both against the context, to prune instantiations, and against the node, which is all
+// that is left to check with RUNTIME_CASTLING_RIGHTS.
+template <Node::Context context>
+void walk_castles(const Node& node, const Bitboard king_danger_set, const auto& visit_move) {
+  using ColorTraits = ColorTraits<context.side_to_move>;
 #define _(SIDE)                                                                                      \
   do {                                                                                               \
-    if constexpr (any(castling_rights & ColorTraits::SIDE##_CASTLING_RIGHTS)) {                      \
+    if constexpr (any(context.castling_rights & ColorTraits::SIDE##_CASTLING_RIGHTS)) {              \
       static constexpr auto& castle = ColorTraits::SIDE##_CASTLE;                                    \
       if (static constexpr auto rook_path =                                                          \
               half_open_segment(square_of(castle.rook_target), square_of(castle.rook_origin));       \
-          empty(board.occupancy() & rook_path) &&                                                    \
+          any(castling_rights_of<context>(node) & ColorTraits::SIDE##_CASTLING_RIGHTS) &&            \
+          empty(node.board.occupancy() & rook_path) &&                                               \
           empty(king_danger_set & (castle.king_origin | castle.rook_target | castle.king_target))) { \
-        visit_move.template operator()<castling_rights>(castle);                                     \
+        visit_move.template operator()<context.castling_rights>(castle);                             \
       }                                                                                              \
     }                                                                                                \
   } while (false)
@@ -105,6 +126,16 @@ void walk_king_moves(const Board& board, const Square king_origin, const auto& v
 #undef _
 }
 
+template <Node::Context context, Stage stage>
+void walk_king_moves(const Node& node, const Constraints& constraints, const auto& visit_move) {
+  walk_non_pawn_quiet_moves_and_captures<context.side_to_move, context.castling_rights, PieceType::KING, stage>(
+      node.board, node.board[context.side_to_move, PieceType::KING],
+      king_attack_set(constraints.king_origin) & ~constraints.king_danger_set, visit_move);
+  if constexpr (stage != Stage::CAPTURES) {
+    walk_castles<context>(node, constraints.king_danger_set, visit_move);
+  }
+}
+
 template <Color side_to_move>
 Bitboard make_checkers(const Board& board, const Square king_origin) noexcept {
   auto checkers = (pawn_left_attack_set(side_to_move, board[side_to_move, PieceType::KING]) |
@@ -137,7 +168,7 @@ constexpr std::pair<Bitboard, Bitboard> make_pinned_and_unpinned(const Board& bo
   return {pinned, origins ^ pinned};
 }
 
-template <Color side_to_move>
+template <Color side_to_move, Stage stage>
 constexpr void walk_pawn_pushes(const Board& board, const Bitboard dg_pin_mask, const Bitboard hv_pin_mask,
                                 const auto& visit_single_push,
                                 const std::invocable<const QuietMove&> auto& visit_double_push,
@@ -146,33 +177,37 @@ constexpr void walk_pawn_pushes(const Board& board, const Bitboard dg_pin_mask,
     const auto unmasked_single_push_targets = pawn_single_push_set(side_to_move, origins) & empty;
     const auto single_push_targets = (unmasked_single_push_targets & ... & target_mask);
     const auto promotion_targets = single_push_targets & ColorTraits<side_to_move>::PROMOTION_RANK;
-    for_each_bit(promotion_targets, [&](const auto target) {
-      for (const auto promotion : {PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK, PieceType::QUEEN}) {
-        visit_single_push(QuietPromotion{
+    if constexpr (stage != Stage::QUIETS) {
+      for_each_bit(promotion_targets, [&](const auto target) {
+        for (const auto promotion : {PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK, PieceType::QUEEN}) {
+          visit_single_push(QuietPromotion{
+              .origin = pawn_single_push_origin(side_to_move, target),
+              .target = target,
+              .promotion = promotion,
+          });
+        }
+      });
+    }
+    if constexpr (stage != Stage::CAPTURES) {
+      for_each_bit(single_push_targets ^ promotion_targets, [&](const auto target) {
+        visit_single_push(QuietMove{
             .origin = pawn_single_push_origin(side_to_move, target),
             .target = target,
-            .promotion = promotion,
+            .piece_type = PieceType::PAWN,
         });
-      }
-    });
-    for_each_bit(single_push_targets ^ promotion_targets, [&](const auto target) {
-      visit_single_push(QuietMove{
-          .origin = pawn_single_push_origin(side_to_move, target),
-          .target = target,
-          .piece_type = PieceType::PAWN,
       });
-    });
-    const auto double_push_targets =
-        pawn_single_push_set(side_to_move,
-                             unmasked_single_push_targets & ColorTraits<side_to_move>::EN_PASSANT_TARGET_RANK) &
-        (empty & ... & target_mask);
-    for_each_bit(double_push_targets, [&](const auto target) {
-      visit_double_push(QuietMove{
-          .origin = pawn_single_push_origin(side_to_move, pawn_single_push_origin(side_to_move, target)),
-          .target = target,
-          .piece_type = PieceType::PAWN,
+      const auto double_push_targets =
+          pawn_single_push_set(side_to_move,
+                               unmasked_single_push_targets & ColorTraits<side_to_move>::EN_PASSANT_TARGET_RANK) &
+          (empty & ... & target_mask);
+      for_each_bit(double_push_targets, [&](const auto target) {
+        visit_double_push(QuietMove{
+            .origin = pawn_single_push_origin(side_to_move, pawn_single_push_origin(side_to_move, target)),
+            .target = target,
+            .piece_type = PieceType::PAWN,
+        });
       });
-    });
+    }
   };
   const auto [pinned, unpinned] =
       make_pinned_and_unpinned<side_to_move, PieceType::PAWN>(board, ~dg_pin_mask, hv_pin_mask);
@@ -258,25 +293,27 @@ constexpr void walk_pawn_captures(const Node& node, const Bitboard dg_pin_mask,
   }
 }
 
-template <Node::Context context>
+template <Node::Context context, Stage stage>
 void walk_pawn_moves(const Node& node, const Bitboard dg_pin_mask, const Bitboard hv_pin_mask,
                      const auto& visit_single_push_or_capture,
                      const std::invocable<const QuietMove&> auto& visit_double_push,
                      const std::same_as<Bitboard> auto... check_mask) {
-  walk_pawn_pushes<context.side_to_move>(
+  walk_pawn_pushes<context.side_to_move, stage>(
       node.board, dg_pin_mask, hv_pin_mask,
       [&](const auto& move) { visit_single_push_or_capture.template operator()<context.castling_rights>(move); },
       visit_double_push, check_mask...);
-  walk_pawn_captures<context>(node, dg_pin_mask, hv_pin_mask, visit_single_push_or_capture, check_mask...);
+  if constexpr (stage != Stage::QUIETS) {
+    walk_pawn_captures<context>(node, dg_pin_mask, hv_pin_mask, visit_single_push_or_capture, check_mask...);
+  }
 }
 
-template <Color side_to_move, CastlingRights castling_rights, PieceType piece_type>
+template <Color side_to_move, CastlingRights castling_rights, PieceType piece_type, Stage stage>
 void walk_piece_moves(const Board& board, const Bitboard origin_mask, const Bitboard pin_mask,
                       const std::invocable<Square> auto& lookup_attack_set, const auto& visit_move,
                       const std::same_as<Bitboard> auto... check_mask) {
   const auto walk_moves = [&](const auto origins, const auto... target_mask) {
     for_each_bit_and_square(origins, [&](const auto origin_bit, const auto origin_square) {
-      walk_non_pawn_quiet_moves_and_captures<side_to_move, castling_rights, piece_type>(
+      walk_non_pawn_quiet_moves_and_captures<side_to_move, castling_rights, piece_type, stage>(
           board, origin_bit, (lookup_attack_set(origin_square) & ... & target_mask), visit_move);
     });
   };
@@ -287,43 +324,23 @@ void walk_piece_moves(const Board& board, const Bitboard origin_mask, const Bitb
   }
 }
 
-template <Node::Context context, typename T>
-void walk_non_king_moves(const Node& node, const Square king_origin, Visitor<T>& visitor,
-                         const std::same_as<Bitboard> auto... check_mask) {
-  const auto dg_pin_mask =
-      make_pin_mask<context.side_to_move, PieceType::BISHOP>(node.board, king_origin, bishop_attack_set);
-  const auto hv_pin_mask =
-      make_pin_mask<context.side_to_move, PieceType::ROOK>(node.board, king_origin, rook_attack_set);
-  walk_pawn_moves<context>(
-      node, dg_pin_mask, hv_pin_mask,
-      [&]<auto new_castling_rights>(const auto& move) {
-        visitor.template visit_pawn_move<context.move(new_castling_rights)>(move);
-      },
-      [&](const QuietMove& double_push) {
-        any(node.board[!context.side_to_move, PieceType::PAWN] &
-            (shift(double_push.target, Direction::EAST) | shift(double_push.target, Direction::WEST)))
-            ? visitor.template visit_pawn_move<context.enable_en_passant()>(double_push)
-            : visitor.template visit_pawn_move<context.move(context.castling_rights)>(double_push);
-      },
-      check_mask...);
-  walk_piece_moves<context.side_to_move, context.castling_rights, PieceType::KNIGHT>(
-      node.board, ~(dg_pin_mask | hv_pin_mask), Bitboard(), knight_attack_set,
-      [&]<auto new_castling_rights>(const auto& move) {
-        visitor.template visit_knight_move<context.move(new_castling_rights)>(move);
-      },
-      check_mask...);
-  walk_piece_moves<context.side_to_move, context.castling_rights, PieceType::BISHOP>(
-      node.board, ~hv_pin_mask, dg_pin_mask,
-      [&](const auto origin) { return bishop_attack_set(origin, node.board.occupancy()); },
-      [&]<auto new_castling_rights>(const auto& move) {
-        visitor.template visit_bishop_move<context.move(new_castling_rights)>(move);
-      },
-      check_mask...);
-  walk_piece_moves<context.side_to_move, context.castling_rights, PieceType::ROOK>(
-      node.board, ~dg_pin_mask, hv_pin_mask,
-      [&](const auto origin) { return rook_attack_set(origin, node.board.occupancy()); },
-      [&]<auto new_castling_rights>(const auto& move) {
-        using ColorTraits = ColorTraits<context.side_to_move>;
+template <Node::Context context, PieceType piece_type, typename T>
+constexpr auto make_visit_move(Visitor<T>& visitor) noexcept {
+  if constexpr (piece_type == PieceType::PAWN) {
+    return [&visitor]<auto new_castling_rights>(const auto& move) {
+      visitor.template visit_pawn_move<context.move(new_castling_rights)>(move);
+    };
+  } else if constexpr (piece_type == PieceType::KNIGHT) {
+    return [&visitor]<auto new_castling_rights>(const auto& move) {
+      visitor.template visit_knight_move<context.move(new_castling_rights)>(move);
+    };
+  } else if constexpr (piece_type == PieceType::BISHOP) {
+    return [&visitor]<auto new_castling_rights>(const auto& move) {
+      visitor.template visit_bishop_move<context.move(new_castling_rights)>(move);
+    };
+  } else if constexpr (piece_type == PieceType::ROOK) {
+    return [&visitor]<auto new_castling_rights>(const auto& move) {
+      using ColorTraits = ColorTraits<context.side_to_move>;
 #define _(SIDE)                                                                                                     \
   do {                                                                                                              \
     if constexpr (any(context.castling_rights & ColorTraits::SIDE##_CASTLING_RIGHTS)) {                             \
@@ -334,20 +351,57 @@ void walk_non_king_moves(const Node& node, const Square king_origin, Visitor<T>&
       }                                                                                                             \
     }                                                                                                               \
   } while (false)
-        _(KINGSIDE);
-        _(QUEENSIDE);
+      _(KINGSIDE);
+      _(QUEENSIDE);
 #undef _
-        visitor.template visit_rook_move<context.move(new_castling_rights)>(move);
-      },
-      check_mask...);
+      visitor.template visit_rook_move<context.move(new_castling_rights)>(move);
+    };
+  } else if constexpr (piece_type == PieceType::QUEEN) {
+    return [&visitor]<auto new_castling_rights>(const auto& move) {
+      visitor.template visit_queen_move<context.move(new_castling_rights)>(move);
+    };
+  } else {
+    static_assert(piece_type == PieceType::KING);
+    return [&visitor]<auto new_castling_rights>(const auto& move) {
+      visitor.template visit_king_move<context.move(new_castling_rights &
+                                                    ~ColorTraits<context.side_to_move>::CASTLING_RIGHTS)>(move);
+    };
+  }
+}
+
+template <Node::Context context, typename T>
+constexpr auto make_visit_double_push(const Board& board, Visitor<T>& visitor) noexcept {
+  return [&board, &visitor](const QuietMove& double_push) {
+    any(board[!context.side_to_move, PieceType::PAWN] &
+        (shift(double_push.target, Direction::EAST) | shift(double_push.target, Direction::WEST)))
+        ? visitor.template visit_pawn_move<context.enable_en_passant()>(double_push)
+        : visitor.template visit_pawn_move<context.move(context.castling_rights)>(double_push);
+  };
+}
+
+template <Node::Context context, Stage stage, typename T>
+void walk_non_king_moves(const Node& node, const Constraints& constraints, Visitor<T>& visitor,
+                         const std::same_as<Bitboard> auto... check_mask) {
+  const auto dg_pin_mask = constraints.dg_pin_mask;
+  const auto hv_pin_mask = constraints.hv_pin_mask;
+  walk_pawn_moves<context, stage>(node, dg_pin_mask, hv_pin_mask, make_visit_move<context, PieceType::PAWN>(visitor),
+                                  make_visit_double_push<context>(node.board, visitor), check_mask...);
+  walk_piece_moves<context.side_to_move, context.castling_rights, PieceType::KNIGHT, stage>(
+      node.board, ~(dg_pin_mask | hv_pin_mask), Bitboard(), knight_attack_set,
+      make_visit_move<context, PieceType::KNIGHT>(visitor), check_mask...);
+  walk_piece_moves<context.side_to_move, context.castling_rights, PieceType::BISHOP, stage>(
+      node.board, ~hv_pin_mask, dg_pin_mask,
+      [&](const auto origin) { return bishop_attack_set(origin, node.board.occupancy()); },
+      make_visit_move<context, PieceType::BISHOP>(visitor), check_mask...);
+  walk_piece_moves<context.side_to_move, context.castling_rights, PieceType::ROOK, stage>(
+      node.board, ~dg_pin_mask, hv_pin_mask,
+      [&](const auto origin) { return rook_attack_set(origin, node.board.occupancy()); },
+      make_visit_move<context, PieceType::ROOK>(visitor), check_mask...);
   const auto walk_queen_moves = [&](const auto origin_mask, const auto pin_mask, const auto& lookup_attack_set) {
-    walk_piece_moves<context.side_to_move, context.castling_rights, PieceType::QUEEN>(
+    walk_piece_moves<context.side_to_move, context.castling_rights, PieceType::QUEEN, stage>(
         node.board, origin_mask, pin_mask,
         [&](const auto origin) { return lookup_attack_set(origin, node.board.occupancy()); },
-        [&]<auto new_castling_rights>(const auto& move) {
-          visitor.template visit_queen_move<context.move(new_castling_rights)>(move);
-        },
-        check_mask...);
+        make_visit_move<context, PieceType::QUEEN>(visitor), check_mask...);
   };
   walk_queen_moves(~hv_pin_mask, dg_pin_mask, bishop_attack_set);
   walk_queen_moves(~dg_pin_mask, hv_pin_mask, rook_attack_set);
@@ -355,24 +409,46 @@ void walk_non_king_moves(const Node& node, const Square king_origin, Visitor<T>&
 }  // namespace prodigy::move_generator
 
 export namespace prodigy::move_generator {
-template <Node::Context context, typename T>
-void walk(const Node& node, Visitor<T>&& visitor) {
-  const auto king_origin = square_of(node.board[context.side_to_move, PieceType::KING]);
-  walk_king_moves<context.side_to_move, context.castling_rights>(
-      node.board, king_origin, [&]<auto new_castling_rights>(const auto& move) {
-        visitor.template visit_king_move<context.move(new_castling_rights &
-                                                      ~ColorTraits<context.side_to_move>::CASTLING_RIGHTS)>(move);
-      });
-  switch (const auto checkers = make_checkers<context.side_to_move>(node.board, king_origin); popcount(checkers)) {
+template <Color side_to_move>
+Constraints make_constraints(const Board& board) noexcept {
+  const auto king_origin = square_of(board[side_to_move, PieceType::KING]);
+  Constraints constraints{
+      .king_origin = king_origin,
+      .king_danger_set = make_king_danger_set<side_to_move>(board),
+      .checkers = make_checkers<side_to_move>(board, king_origin),
+  };
+  if (popcount(constraints.checkers) < 2) {
+    constraints.dg_pin_mask = make_pin_mask<side_to_move, PieceType::BISHOP>(board, king_origin, bishop_attack_set);
+    constraints.hv_pin_mask = make_pin_mask<side_to_move, PieceType::ROOK>(board, king_origin, rook_attack_set);
+  }
+  return constraints;
+}
+
+// Stages of a node can share one make_constraints instead of recomputing it per walk.
+// Visitors may also define visit_constraints, which is called with the constraints before any move is visited, so that
+// attacks on the king and pins can be reused without another attack pass.
+template <Node::Context context, Stage stage = Stage::ALL, typename T>
+void walk(const Node& node, const Constraints& constraints, Visitor<T>&& visitor) {
+  if constexpr (requires(T& derived) { derived.visit_constraints(constraints); }) {
+    static_cast<T&>(visitor).visit_constraints(constraints);
+  }
+  walk_king_moves<context, stage>(node, constraints, make_visit_move<context, PieceType::KING>(visitor));
+  switch (popcount(constraints.checkers)) {
     case 0:
-      walk_non_king_moves<context>(node, king_origin, visitor);
+      walk_non_king_moves<context, stage>(node, constraints, visitor);
       break;
     case 1:
-      walk_non_king_moves<context>(node, king_origin, visitor, half_open_segment(square_of(checkers), king_origin));
+      walk_non_king_moves<context, stage>(node, constraints, visitor,
+                                          half_open_segment(square_of(constraints.checkers), constraints.king_origin));
       [[fallthrough]];
     default:
       visitor.is_check();
       break;
   }
 }
+
+template <Node::Context context, Stage stage = Stage::ALL, typename T>
+void walk(const Node& node, Visitor<T>&& visitor) {
+  walk<context, stage>(node, make_constraints<context.side_to_move>(node.board), std::move(visitor));
+}
 }  // namespace prodigy::move_generator
@@ -4,8 +4,10 @@ module;
 #include <asio/io_context.hpp>
 #include <charconv>
 #include <concepts>
+#include <cstddef>
 #include <expected>
 #include <iostream>
+#include <optional>
 #include <string_view>
 #include <utility>
 
@@ -51,10 +53,16 @@ void Engine::handle(std::string_view command) {
     if (token == "uci") {
       std::cout << "id name " << PROJECT_NAME << ' ' << PROJECT_VERSION << '@' << GIT_HASH << '\n';
       std::cout << "id author " << PROJECT_AUTHOR << '\n';
+      for (const auto& option : options()) {
+        std::cout << option << '\n';
+      }
       std::cout << "uciok" << std::endl;
       break;
     }
     if (token == "debug") {
+      if (const auto mode = pop_token(); mode == "on" || mode == "off") {
+        set_debug(mode == "on");
+      }
       break;
     }
     if (token == "isready") {
@@ -62,6 +70,8 @@ void Engine::handle(std::string_view command) {
       break;
     }
     if (token == "setoption") {
+      const auto [name, value] = parse_set_option(options(), command).value();
+      set_option(name, value);
       break;
     }
     if (token == "register") {
@@ -128,6 +138,12 @@ void Engine::handle(std::string_view command) {
       break;
     }
     if (token == "ponderhit") {
+      ponder_hit();
+      break;
+    }
+    if (token == "bench") {
+      const auto simulations = pop_token();
+      bench(simulations.empty() ? std::nullopt : std::optional(parse<std::size_t>(simulations).value()));
       break;
     }
     if (token == "quit") {
@@ -1,5 +1,8 @@
 module;
 
+#include <cstddef>
+#include <optional>
+#include <span>
 #include <string_view>
 
 namespace asio {
@@ -12,6 +15,7 @@ import prodigy.core;
 
 import :go;
 import :move;
+import :option;
 
 export namespace prodigy::uci {
 class Engine {
@@ -23,6 +27,9 @@ class Engine {
   void handle(std::string_view);
 
  private:
+  // Whether to send info strings that help debugging.
+  virtual void set_debug(bool) = 0;
+
   virtual void set_position(const Position&) = 0;
 
   virtual void apply(Move) = 0;
@@ -31,6 +38,17 @@ class Engine {
 
   virtual void stop() = 0;
 
+  // The opponent played the move pondered on, so the search turns into a normal one.
+  virtual void ponder_hit() = 0;
+
+  virtual std::span<const Option> options() const = 0;
+
+  virtual void set_option(std::string_view name, const Option::Value&) = 0;
+
+  // Not part of UCI. Searches a fixed set of positions, with as many simulations each as given or a default, and
+  // reports the speed and a signature of the searches.
+  virtual void bench(std::optional<std::size_t> simulations) = 0;
+
   asio::io_context& io_context_;
 };
 }  // namespace prodigy::uci
@@ -0,0 +1,36 @@
+module;
+
+#include <iostream>
+
+module prodigy.uci;
+
+namespace prodigy::uci {
+std::ostream& operator<<(std::ostream& os, const Info& info) {
+  os << "info";
+#define _(TOKEN, FIELD)                 \
+  if (info.FIELD.has_value()) {         \
+    os << " " TOKEN " " << *info.FIELD; \
+  }
+  _("depth", depth)
+  _("seldepth", selective_depth)
+  _("multipv", multi_pv)
+  _("score cp", centipawns)
+  _("nodes", nodes)
+  _("nps", nodes_per_second)
+  _("hashfull", hash_full)
+#undef _
+  if (info.time.has_value()) {
+    os << " time " << info.time->count();
+  }
+  if (!info.principal_variation.empty()) {
+    os << " pv";
+    for (const auto move : info.principal_variation) {
+      os << ' ' << move;
+    }
+  }
+  if (!info.string.empty()) {
+    os << " string " << info.string;
+  }
+  return os;
+}
+}  // namespace prodigy::uci
@@ -0,0 +1,35 @@
+module;
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+
+export module prodigy.uci:info;
+
+import :move;
+
+export namespace prodigy::uci {
+// A progress report, printed as an info line. Unset fields are left out.
+struct Info {
+  std::optional<std::size_t> depth;
+  std::optional<std::size_t> selective_depth;
+  std::optional<std::size_t> multi_pv;
+  std::optional<std::int32_t> centipawns;
+  std::optional<std::size_t> nodes;
+  std::optional<std::size_t> nodes_per_second;
+  // In permille.
+  std::optional<std::size_t> hash_full;
+  std::optional<std::chrono::milliseconds> time;
+  std::vector<Move> principal_variation;
+  // Free text, printed last since it runs to the end of the line.
+  std::string string;
+
+  friend bool operator==(const Info&, const Info&) = default;
+};
+
+std::ostream& operator<<(std::ostream&, const Info&);
+}  // namespace prodigy::uci
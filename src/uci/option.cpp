@@ -0,0 +1,110 @@
+module;
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <expected>
+#include <iostream>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <variant>
+
+module prodigy.uci;
+
+namespace prodigy::uci {
+std::ostream& operator<<(std::ostream& os, const Option& option) {
+  os << "option name " << option.name << " type ";
+  switch (option.type) {
+    case Option::Type::CHECK:
+      return os << "check default " << option.default_value;
+    case Option::Type::SPIN:
+      return os << "spin default " << option.default_value << " min " << option.min << " max " << option.max;
+    case Option::Type::COMBO:
+      os << "combo default " << option.default_value;
+      for (const auto var : option.vars) {
+        os << " var " << var;
+      }
+      return os;
+    case Option::Type::BUTTON:
+      return os << "button";
+    case Option::Type::STRING:
+      return os << "string default " << (option.default_value.empty() ? "<empty>" : option.default_value);
+  }
+  std::unreachable();
+}
+
+namespace {
+constexpr bool equals_ignoring_case(const std::string_view lhs, const std::string_view rhs) noexcept {
+  return std::ranges::equal(lhs, rhs, [](const unsigned char lhs, const unsigned char rhs) {
+    return std::tolower(lhs) == std::tolower(rhs);
+  });
+}
+}  // namespace
+
+std::expected<std::pair<std::string_view, Option::Value>, std::string_view> parse_set_option(
+    const std::span<const Option> options, std::string_view arguments) {
+  static constexpr auto WHITESPACE = " \f\r\t\v";
+  const auto pop_token = [&] -> std::string_view {
+    const auto begin = arguments.find_first_not_of(WHITESPACE);
+    if (begin == std::string_view::npos) {
+      return {};
+    }
+    const auto end = std::min(arguments.find_first_of(WHITESPACE, begin), arguments.size());
+    const auto token = arguments.substr(begin, end - begin);
+    arguments.remove_prefix(end);
+    return token;
+  };
+  if (pop_token() != "name") {
+    return std::unexpected("Missing name.");
+  }
+  std::string_view name;
+  std::string_view value;
+  for (auto token = pop_token(); !token.empty(); token = pop_token()) {
+    if (token == "value") {
+      const auto begin = std::min(arguments.find_first_not_of(WHITESPACE), arguments.size());
+      value = arguments.substr(begin, arguments.find_last_not_of(WHITESPACE) + 1 - begin);
+      break;
+    }
+    // Names may contain spaces, which are kept as given.
+    name = name.empty() ? token : std::string_view(name.data(), token.data() + token.size());
+  }
+  const auto option = std::ranges::find_if(
+      options, [&](const Option& option) { return equals_ignoring_case(option.name, name); });
+  if (option == options.end()) {
+    return std::unexpected("Unknown option.");
+  }
+  const auto make_result = [&](const Option::Value& parsed) { return std::pair(option->name, parsed); };
+  switch (option->type) {
+    case Option::Type::CHECK:
+      if (value == "true" || value == "false") {
+        return make_result(value == "true");
+      }
+      return std::unexpected("Invalid check value.");
+    case Option::Type::SPIN: {
+      std::int64_t spin;
+      if (std::from_chars(value.begin(), value.end(), spin) != std::from_chars_result{value.end(), std::errc()}) {
+        return std::unexpected("Invalid spin value.");
+      }
+      if (spin < option->min || spin > option->max) {
+        return std::unexpected("Spin value out of range.");
+      }
+      return make_result(spin);
+    }
+    case Option::Type::COMBO:
+      if (const auto var = std::ranges::find_if(option->vars,
+                                                [&](const auto var) { return equals_ignoring_case(var, value); });
+          var != option->vars.end()) {
+        return make_result(*var);
+      }
+      return std::unexpected("Invalid combo value.");
+    case Option::Type::BUTTON:
+      return make_result(std::monostate());
+    case Option::Type::STRING:
+      return make_result(value == "<empty>" ? std::string_view() : value);
+  }
+  std::unreachable();
+}
+}  // namespace prodigy::uci
@@ -0,0 +1,44 @@
+module;
+
+#include <cstdint>
+#include <expected>
+#include <iosfwd>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+export module prodigy.uci:option;
+
+export namespace prodigy::uci {
+// An option advertised in reply to uci and set with setoption.
+struct Option {
+  enum class Type : std::uint8_t {
+    CHECK,
+    SPIN,
+    COMBO,
+    BUTTON,
+    STRING,
+  };
+
+  // Buttons have no value, checks are bools, spins integers, and combos and strings text.
+  using Value = std::variant<std::monostate, bool, std::int64_t, std::string_view>;
+
+  std::string_view name;
+  Type type;
+  std::string_view default_value;
+  // Spins only.
+  std::int64_t min = 0;
+  std::int64_t max = 0;
+  // Combos only.
+  std::vector<std::string_view> vars;
+};
+
+std::ostream& operator<<(std::ostream&, const Option&);
+
+// Parses the arguments of setoption, "name <id> [value <x>]", into the name of the matching option and its value. Names
+// and combo values match case-insensitively. The value views the option for combos and the arguments for strings.
+[[nodiscard]] std::expected<std::pair<std::string_view, Option::Value>, std::string_view> parse_set_option(
+    std::span<const Option>, std::string_view arguments);
+}  // namespace prodigy::uci
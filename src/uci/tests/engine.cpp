@@ -3,10 +3,15 @@
 #include <catch2/generators/catch_generators.hpp>
 #include <catch2/matchers/catch_matchers_vector.hpp>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <format>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <variant>
 #include <vector>
 
 import prodigy.core;
@@ -31,6 +36,14 @@ class MockEngine : public Engine {
 
   const std::vector<Move>& moves() const noexcept { return moves_; }
 
+  const std::vector<std::pair<std::string_view, Option::Value>>& set_options() const noexcept { return set_options_; }
+
+  std::size_t ponder_hits() const noexcept { return ponder_hits_; }
+
+  const std::vector<std::optional<std::size_t>>& benches() const noexcept { return benches_; }
+
+  const std::vector<bool>& debugs() const noexcept { return debugs_; }
+
   const Go& go_params() const noexcept {
     REQUIRE(go_params_.has_value());
     return *go_params_;
@@ -39,6 +52,8 @@ class MockEngine : public Engine {
   State state() const noexcept { return io_context_.stopped() ? State::QUIT : state_; }
 
  private:
+  void set_debug(const bool debug) override { debugs_.push_back(debug); }
+
   void set_position(const Position& position) override {
     position_.emplace(position);
     moves_.clear();
@@ -56,10 +71,41 @@ class MockEngine : public Engine {
     go_params_.reset();
   }
 
+  void ponder_hit() override {
+    REQUIRE(state_ == State::SEARCHING);
+    ++ponder_hits_;
+  }
+
+  std::span<const Option> options() const override { return OPTIONS; }
+
+  void set_option(const std::string_view name, const Option::Value& value) override {
+    set_options_.emplace_back(name, value);
+  }
+
+  void bench(const std::optional<std::size_t> simulations) override { benches_.push_back(simulations); }
+
+  static inline const std::vector<Option> OPTIONS{
+      {
+          .name = "Threads",
+          .type = Option::Type::SPIN,
+          .default_value = "1",
+          .min = 1,
+          .max = 8,
+      },
+      {
+          .name = "Clear Hash",
+          .type = Option::Type::BUTTON,
+      },
+  };
+
   const asio::io_context& io_context_;
   std::optional<const Position> position_;
   std::vector<Move> moves_;
+  std::vector<std::pair<std::string_view, Option::Value>> set_options_;
   std::optional<const Go> go_params_;
+  std::size_t ponder_hits_ = 0;
+  std::vector<std::optional<std::size_t>> benches_;
+  std::vector<bool> debugs_;
   State state_ = State::IDLE;
 };
 
@@ -196,10 +242,42 @@ TEST_CASE("parse") {
     REQUIRE(engine.state() == MockEngine::State::SEARCHING);
     REQUIRE(engine.go_params() == Go());
   }
+  SECTION("setoption") {
+    engine.handle("setoption name threads value 4");
+    engine.handle("setoption name clear hash");
+    REQUIRE(engine.set_options() == std::vector<std::pair<std::string_view, Option::Value>>{
+                                        {"Threads", std::int64_t{4}},
+                                        {"Clear Hash", std::monostate()},
+                                    });
+    REQUIRE_THROWS(engine.handle("setoption name Threads value 9"));
+    REQUIRE_THROWS(engine.handle("setoption name Hash value 1"));
+    REQUIRE(engine.set_options().size() == 2);
+  }
   SECTION("stop") {
     engine.handle("stop");
     REQUIRE(engine.state() == MockEngine::State::IDLE);
   }
+  SECTION("ponderhit") {
+    engine.handle("go ponder wtime 1000 btime 1000");
+    REQUIRE(engine.go_params().ponder);
+    engine.handle("ponderhit");
+    REQUIRE(engine.ponder_hits() == 1);
+    REQUIRE(engine.state() == MockEngine::State::SEARCHING);
+  }
+  SECTION("bench") {
+    engine.handle("bench");
+    engine.handle("bench 1000");
+    REQUIRE(engine.benches() == std::vector<std::optional<std::size_t>>{std::nullopt, 1000});
+    REQUIRE_THROWS(engine.handle("bench many"));
+    REQUIRE(engine.benches().size() == 2);
+  }
+  SECTION("debug") {
+    engine.handle("debug on");
+    engine.handle("debug off");
+    engine.handle("debug");
+    engine.handle("debug maybe");
+    REQUIRE(engine.debugs() == std::vector{true, false});
+  }
   SECTION("quit") {
     engine.handle("quit");
     REQUIRE(engine.state() == MockEngine::State::QUIT);
@@ -0,0 +1,33 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <sstream>
+
+import prodigy.uci;
+
+namespace prodigy::uci {
+namespace {
+TEST_CASE("print") {
+  using namespace std::literals::chrono_literals;
+  std::ostringstream os;
+  os << Info();
+  REQUIRE(os.str() == "info");
+  os.str("");
+  os << Info{
+      .depth = 3,
+      .selective_depth = 7,
+      .multi_pv = 2,
+      .centipawns = -35,
+      .nodes = 12345,
+      .nodes_per_second = 67890,
+      .hash_full = 12,
+      .time = 182ms,
+      .principal_variation = {parse_move("e2e4").value(), parse_move("e7e5").value(), parse_move("g1f3").value()},
+  };
+  REQUIRE(os.str() == "info depth 3 seldepth 7 multipv 2 score cp -35 nodes 12345 nps 67890 hashfull 12 time 182 pv "
+                      "e2e4 e7e5 g1f3");
+  os.str("");
+  os << Info{.nodes = 42, .string = "searcher 0 maxdepth 3"};
+  REQUIRE(os.str() == "info nodes 42 string searcher 0 maxdepth 3");
+}
+}  // namespace
+}  // namespace prodigy::uci
@@ -0,0 +1,78 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <cstdint>
+#include <expected>
+#include <sstream>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+import prodigy.uci;
+
+namespace prodigy::uci {
+namespace {
+const std::vector<Option> OPTIONS{
+    {
+        .name = "Ponder",
+        .type = Option::Type::CHECK,
+        .default_value = "false",
+    },
+    {
+        .name = "Hash",
+        .type = Option::Type::SPIN,
+        .default_value = "16",
+        .min = 1,
+        .max = 1024,
+    },
+    {
+        .name = "Rollout Policy",
+        .type = Option::Type::COMBO,
+        .default_value = "Evaluation",
+        .vars = {"Evaluation", "Network"},
+    },
+    {
+        .name = "Clear Hash",
+        .type = Option::Type::BUTTON,
+    },
+    {
+        .name = "Network File",
+        .type = Option::Type::STRING,
+    },
+};
+
+TEST_CASE("print") {
+  const auto [option, expected_string] = GENERATE(table<Option, std::string_view>({
+      {OPTIONS[0], "option name Ponder type check default false"},
+      {OPTIONS[1], "option name Hash type spin default 16 min 1 max 1024"},
+      {OPTIONS[2], "option name Rollout Policy type combo default Evaluation var Evaluation var Network"},
+      {OPTIONS[3], "option name Clear Hash type button"},
+      {OPTIONS[4], "option name Network File type string default <empty>"},
+  }));
+  std::ostringstream os;
+  os << option;
+  REQUIRE(os.str() == expected_string);
+}
+
+TEST_CASE("parse_set_option") {
+  using Result = std::expected<std::pair<std::string_view, Option::Value>, std::string_view>;
+  const auto [arguments, expected_result] = GENERATE(table<std::string_view, Result>({
+      {"name Ponder value true", std::pair("Ponder", true)},
+      {"name ponder value false", std::pair("Ponder", false)},
+      {"name Ponder value yes", std::unexpected("Invalid check value.")},
+      {"name Hash value 256", std::pair("Hash", std::int64_t{256})},
+      {"name HASH value 0", std::unexpected("Spin value out of range.")},
+      {"name Hash value 1x", std::unexpected("Invalid spin value.")},
+      {"name Rollout Policy value network", std::pair("Rollout Policy", std::string_view("Network"))},
+      {"name Rollout Policy value Random", std::unexpected("Invalid combo value.")},
+      {"name Clear Hash", std::pair("Clear Hash", std::monostate())},
+      {"name Network File value /tmp/a b.nnue ", std::pair("Network File", std::string_view("/tmp/a b.nnue"))},
+      {"name Network File value <empty>", std::pair("Network File", std::string_view())},
+      {"name Threads value 4", std::unexpected("Unknown option.")},
+      {"Hash value 4", std::unexpected("Missing name.")},
+  }));
+  INFO(arguments);
+  REQUIRE(parse_set_option(OPTIONS, arguments) == expected_result);
+}
+}  // namespace
+}  // namespace prodigy::uci
@@ -2,4 +2,6 @@ export module prodigy.uci;
 
 export import :engine;
 export import :go;
+export import :info;
 export import :move;
+export import :option;